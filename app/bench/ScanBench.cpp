@@ -0,0 +1,324 @@
+// Scanner benchmark: builds synthetic trees with TreeGenerator and times
+// FileScanner over them. Run through `make bench BENCH_ARGS="..."`.
+
+#include "FileScanner.hpp"
+#include "NameFilter.hpp"
+#include "ScanSnapshot.hpp"
+#include "TreeGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BenchOptions {
+    fs::path root;
+    std::vector<size_t> sizes{100000};
+    TreeSpec spec;
+    int repeat{3};
+    unsigned int threads{0};
+    bool keep{false};
+    bool csv{false};
+};
+
+struct Scenario {
+    const char *name;
+    // Returns the number of entries the scan produced.
+    std::function<size_t()> run;
+};
+
+void print_usage()
+{
+    std::printf(
+        "usage: scan_bench [options]\n"
+        "  --root DIR           where trees are generated (default: /dev/shm or the temp dir)\n"
+        "  --entries N[,N...]   entries per tree, e.g. 1000,100000,5000000 (default 100000)\n"
+        "  --depth D            directory levels below the root (default 4)\n"
+        "  --files-per-dir N    files per directory (default 64)\n"
+        "  --hidden-ratio R     share of hidden files (default 0.05)\n"
+        "  --bundle-ratio R     share of .app bundles (default 0.01)\n"
+        "  --junk-ratio R       share of junk files (default 0.01)\n"
+        "  --repeat N           runs per scenario, the best one is reported (default 3)\n"
+        "  --threads N          scanner worker threads (default: hardware concurrency)\n"
+        "  --keep               leave the generated trees in place\n"
+        "  --csv                machine-readable output\n");
+}
+
+fs::path default_root()
+{
+    std::error_code ec;
+    if (fs::is_directory("/dev/shm", ec)) {
+        return "/dev/shm/aifilesorter-bench";
+    }
+    return fs::temp_directory_path() / "aifilesorter-bench";
+}
+
+std::vector<size_t> parse_sizes(std::string_view value)
+{
+    std::vector<size_t> sizes;
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        sizes.push_back(std::stoull(std::string(value.substr(0, comma))));
+        value = comma == std::string_view::npos ? std::string_view{} : value.substr(comma + 1);
+    }
+    return sizes;
+}
+
+bool parse_options(int argc, char **argv, BenchOptions &options)
+{
+    options.root = default_root();
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(std::string(arg) + " needs a value");
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--root") options.root = value();
+        else if (arg == "--entries") options.sizes = parse_sizes(value());
+        else if (arg == "--depth") options.spec.depth = std::stoi(value());
+        else if (arg == "--files-per-dir") options.spec.files_per_directory = std::stoull(value());
+        else if (arg == "--hidden-ratio") options.spec.hidden_ratio = std::stod(value());
+        else if (arg == "--bundle-ratio") options.spec.bundle_ratio = std::stod(value());
+        else if (arg == "--junk-ratio") options.spec.junk_ratio = std::stod(value());
+        else if (arg == "--repeat") options.repeat = std::max(std::stoi(value()), 1);
+        else if (arg == "--threads") options.threads = static_cast<unsigned int>(std::stoul(value()));
+        else if (arg == "--keep") options.keep = true;
+        else if (arg == "--csv") options.csv = true;
+        else {
+            print_usage();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Peak resident set size of the process so far, in MiB.
+double peak_rss_mib()
+{
+#ifdef _WIN32
+    return 0.0;
+#else
+#ifdef __linux__
+    // VmHWM honours a reset through /proc/self/clear_refs, ru_maxrss does not.
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stod(line.substr(6)) / 1024.0;
+        }
+    }
+#endif
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+}
+
+struct ScenarioResult {
+    double best_seconds{std::numeric_limits<double>::max()};
+    size_t produced{0};
+    double peak_rss_mib{0.0};
+};
+
+ScenarioResult measure(const Scenario &scenario, int repeat)
+{
+    ScenarioResult result;
+    for (int run = 0; run < repeat; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        result.produced = scenario.run();
+        result.best_seconds = std::min(result.best_seconds, std::chrono::duration<double>(
+                                           std::chrono::steady_clock::now() - start).count());
+    }
+    result.peak_rss_mib = peak_rss_mib();
+    return result;
+}
+
+// Runs the scenario in a child process so its peak RSS is not inflated by
+// the scenarios before it, which the allocator keeps memory around for.
+ScenarioResult measure_isolated(const Scenario &scenario, int repeat)
+{
+#ifdef _WIN32
+    return measure(scenario, repeat);
+#else
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return measure(scenario, repeat);
+    }
+    std::fflush(stdout);
+    const pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return measure(scenario, repeat);
+    }
+    if (child == 0) {
+        close(fds[0]);
+#ifdef __linux__
+        // The child starts with the parent's high-water mark.
+        std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+        ScenarioResult result = measure(scenario, repeat);
+        const bool written = write(fds[1], &result, sizeof(result)) == sizeof(result);
+        _exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    ScenarioResult result;
+    const bool complete = read(fds[0], &result, sizeof(result)) == sizeof(result);
+    close(fds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!complete || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        throw std::runtime_error(std::string("scenario ") + scenario.name + " failed");
+    }
+    return result;
+#endif
+}
+
+void run_tree(const BenchOptions &options, size_t entries)
+{
+    TreeSpec spec = options.spec;
+    spec.entries = entries;
+    const fs::path tree = options.root / ("tree_" + std::to_string(entries));
+    fs::remove_all(tree);
+
+    auto generate_start = std::chrono::steady_clock::now();
+    TreeStats stats = TreeGenerator(spec).generate(tree);
+    auto generated = std::chrono::steady_clock::now();
+    const std::string root = tree.string();
+
+    if (!options.csv) {
+        std::printf("\n%s: %zu dirs, %zu files, %zu hidden, %zu bundles, %zu junk (generated in %.1f s)\n",
+                    root.c_str(), stats.directories, stats.files, stats.hidden, stats.bundles,
+                    stats.junk, std::chrono::duration<double>(generated - generate_start).count());
+    }
+
+    // The snapshot only trusts listings whose mtime has settled, see FileScanner.
+    std::this_thread::sleep_until(generated + std::chrono::milliseconds(2100));
+
+    FileScanner scanner;
+    scanner.set_thread_count(options.threads);
+    // Directories handed out as entries are not descended into, so the
+    // recursive scenarios ask for files only to walk the whole tree.
+    const auto recursive = FileScanOptions::Files | FileScanOptions::Recursive;
+    auto count_entries = [](size_t &count) {
+        return [&count](FileEntry &&) { ++count; return true; };
+    };
+
+    ScanSnapshotIndex warm_snapshot;
+    auto default_filter = std::make_shared<const NameFilter>(
+        std::vector<std::string>{"*.part", "*.crdownload", "~$*"}, std::vector<std::string>{});
+
+    std::vector<Scenario> scenarios = {
+        {"flat", [&] {
+            return scanner.get_directory_entries(root, FileScanOptions::Files |
+                                                       FileScanOptions::Directories).size();
+        }},
+        {"recursive", [&] {
+            return scanner.get_directory_entries(root, recursive).size();
+        }},
+        {"recursive+hidden", [&] {
+            return scanner.get_directory_entries(root, recursive | FileScanOptions::HiddenFiles).size();
+        }},
+        {"recursive+filter", [&] {
+            scanner.set_name_filter(default_filter);
+            size_t count = scanner.get_directory_entries(root, recursive).size();
+            scanner.set_name_filter(nullptr);
+            return count;
+        }},
+        {"streamed", [&] {
+            size_t count = 0;
+            scanner.scan_directory_entries(root, recursive, count_entries(count));
+            return count;
+        }},
+        {"snapshot-cold", [&] {
+            ScanSnapshotIndex snapshot;
+            size_t count = 0;
+            scanner.scan_directory_entries(root, recursive, count_entries(count), 0, &snapshot);
+            return count;
+        }},
+        {"snapshot-warm", [&] {
+            size_t count = 0;
+            if (warm_snapshot.size() == 0) {
+                scanner.scan_directory_entries(root, recursive, count_entries(count), 0, &warm_snapshot);
+                count = 0;
+            }
+            scanner.scan_directory_entries(root, recursive, count_entries(count), 0, &warm_snapshot);
+            return count;
+        }},
+    };
+
+    if (!options.csv) {
+        std::printf("%-18s %10s %10s %14s %12s\n", "scenario", "entries", "best ms", "entries/s",
+                    "peak RSS MiB");
+    }
+    for (const auto &scenario : scenarios) {
+        const ScenarioResult result = measure_isolated(scenario, options.repeat);
+        const double best = result.best_seconds;
+        const double rate = best > 0 ? static_cast<double>(result.produced) / best : 0.0;
+        if (options.csv) {
+            std::printf("%zu,%s,%zu,%.3f,%.0f,%.1f\n", entries, scenario.name, result.produced,
+                        best * 1000.0, rate, result.peak_rss_mib);
+        } else {
+            std::printf("%-18s %10zu %10.1f %14.0f %12.1f\n", scenario.name, result.produced,
+                        best * 1000.0, rate, result.peak_rss_mib);
+        }
+    }
+
+    if (!options.keep) {
+        fs::remove_all(tree);
+    }
+}
+
+} // namespace
+
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            return EXIT_FAILURE;
+        }
+        if (options.csv) {
+            std::printf("tree_entries,scenario,entries,best_ms,entries_per_sec,peak_rss_mib\n");
+        }
+        for (size_t entries : options.sizes) {
+            run_tree(options, entries);
+        }
+        if (!options.keep) {
+            std::error_code ec;
+            fs::remove(options.root, ec);
+        }
+    } catch (const std::exception &ex) {
+        std::fprintf(stderr, "scan_bench: %s\n", ex.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+// Label similarity benchmark: times the textbook DP that string_similarity
+// used against EditDistance, unbounded and with the fuzzy match threshold,
+// on taxonomy-style labels. Run through `make bench-similarity`.
+
+#include "EditDistance.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr double kThreshold = 0.85;
+
+const char *const kLabels[] = {
+    "documents", "images", "photos", "screenshots", "wallpapers", "music", "podcasts",
+    "audiobooks", "videos", "movies", "tv shows", "archives", "backups", "installers",
+    "software", "drivers", "fonts", "ebooks", "books", "comics", "spreadsheets",
+    "presentations", "invoices", "receipts", "bank statements", "tax returns", "payslips",
+    "contracts", "letters", "resumes", "certificates", "manuals", "datasheets",
+    "source code", "scripts", "configuration files", "logs", "databases", "disk images",
+    "virtual machines", "3d models", "cad drawings", "vector graphics", "raw photos",
+    "design assets", "game saves", "mods", "subtitles", "torrents", "email attachments",
+    "travel documents", "medical records", "insurance policies", "school work",
+    "research papers", "lecture notes", "recipes", "maps", "gps tracks", "ringtones",
+    "sound effects", "sheet music", "project files", "temporary files", "miscellaneous",
+    "financial reports for the second quarter of the fiscal year",
+    "photos from the family trip to the mountains in late summer",
+};
+
+struct Pair {
+    std::string a;
+    std::string b;
+};
+
+struct BenchOptions {
+    size_t pairs{200000};
+    int repeat{5};
+    bool csv{false};
+};
+
+// The implementation string_similarity had before EditDistance.
+double reference_similarity(const std::string &a, const std::string &b)
+{
+    if (a == b) {
+        return 1.0;
+    }
+    if (a.empty() || b.empty()) {
+        return 0.0;
+    }
+
+    const size_t m = a.size();
+    const size_t n = b.size();
+    std::vector<size_t> prev(n + 1), curr(n + 1);
+    for (size_t j = 0; j <= n; ++j) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= m; ++i) {
+        curr[0] = i;
+        for (size_t j = 1; j <= n; ++j) {
+            size_t cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            curr[j] = std::min({prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + cost});
+        }
+        std::swap(prev, curr);
+    }
+    return 1.0 - static_cast<double>(prev[n]) / static_cast<double>(std::max(m, n));
+}
+
+// What an LLM answer looks like next to the stored label: mostly the same
+// label with a typo, plural or extra word, sometimes an unrelated one.
+std::string vary(std::string label, std::mt19937 &rng)
+{
+    const std::string_view letters = "abcdefghijklmnopqrstuvwxyz ";
+    switch (rng() % 5) {
+    case 0:
+        return label;
+    case 1: {
+        size_t pos = rng() % label.size();
+        label[pos] = letters[rng() % letters.size()];
+        return label;
+    }
+    case 2:
+        return label + "s";
+    case 3:
+        return "my " + label;
+    default:
+        return kLabels[rng() % std::size(kLabels)];
+    }
+}
+
+std::vector<Pair> make_pairs(size_t count)
+{
+    std::mt19937 rng(42);
+    std::vector<Pair> pairs;
+    pairs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string label = kLabels[rng() % std::size(kLabels)];
+        pairs.push_back({vary(label, rng), std::move(label)});
+    }
+    return pairs;
+}
+
+void print_usage()
+{
+    std::printf(
+        "usage: similarity_bench [options]\n"
+        "  --pairs N     label pairs compared per run (default 200000)\n"
+        "  --repeat N    runs per kernel, the best one is reported (default 5)\n"
+        "  --csv         machine-readable output\n");
+}
+
+bool parse_options(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(std::string(arg) + " needs a value");
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--pairs") options.pairs = std::max<size_t>(std::stoull(value()), 1);
+        else if (arg == "--repeat") options.repeat = std::max(std::stoi(value()), 1);
+        else if (arg == "--csv") options.csv = true;
+        else {
+            print_usage();
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception &ex) {
+        std::fprintf(stderr, "similarity_bench: %s\n", ex.what());
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Pair> pairs = make_pairs(options.pairs);
+
+    // The kernels must agree before their timings mean anything.
+    for (const auto &pair : pairs) {
+        double expected = reference_similarity(pair.a, pair.b);
+        double bounded = EditDistance::similarity(pair.a, pair.b, kThreshold);
+        if (EditDistance::similarity(pair.a, pair.b) != expected ||
+            bounded != (expected >= kThreshold ? expected : 0.0)) {
+            std::fprintf(stderr, "similarity_bench: mismatch for \"%s\" / \"%s\"\n",
+                         pair.a.c_str(), pair.b.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct Kernel {
+        const char *name;
+        std::function<double(const Pair &)> run;
+    };
+    const std::vector<Kernel> kernels = {
+        {"reference-dp", [](const Pair &p) { return reference_similarity(p.a, p.b); }},
+        {"bit-parallel", [](const Pair &p) { return EditDistance::similarity(p.a, p.b); }},
+        {"bit-parallel@0.85", [](const Pair &p) {
+            return EditDistance::similarity(p.a, p.b, kThreshold);
+        }},
+    };
+
+    if (options.csv) {
+        std::printf("kernel,pairs,best_ms,ns_per_pair\n");
+    } else {
+        std::printf("%-18s %10s %10s %12s\n", "kernel", "pairs", "best ms", "ns/pair");
+    }
+    double checksum = 0.0;
+    for (const auto &kernel : kernels) {
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < options.repeat; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            for (const auto &pair : pairs) {
+                checksum += kernel.run(pair);
+            }
+            best = std::min(best, std::chrono::duration<double>(
+                                      std::chrono::steady_clock::now() - start).count());
+        }
+        const double per_pair = best * 1e9 / static_cast<double>(pairs.size());
+        if (options.csv) {
+            std::printf("%s,%zu,%.3f,%.1f\n", kernel.name, pairs.size(), best * 1000.0, per_pair);
+        } else {
+            std::printf("%-18s %10zu %10.1f %12.1f\n", kernel.name, pairs.size(), best * 1000.0,
+                        per_pair);
+        }
+    }
+    // Keeps the compiler from dropping the timed calls.
+    if (checksum < 0.0) {
+        std::printf("%f\n", checksum);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include "TreeGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char *kExtensions[] = {
+    "jpg", "png", "pdf", "docx", "xlsx", "mp3", "mp4", "zip", "txt", "csv",
+    "iso", "epub", "json", "cpp", "heic", "mkv"
+};
+
+// Names FileScanner drops itself, followed by ones the default
+// ExcludePatterns catch; the fixed names fit at most once per directory.
+constexpr const char *kFixedJunk[] = {".DS_Store", "Thumbs.db", "desktop.ini"};
+
+void create_file(const fs::path &path)
+{
+#ifdef _WIN32
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot create " + path.string());
+    }
+#else
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create " + path.string());
+    }
+    ::close(fd);
+#endif
+}
+
+} // namespace
+
+
+TreeStats TreeGenerator::generate(const fs::path &root) const
+{
+    if (fs::exists(root)) {
+        throw std::runtime_error(root.string() + " already exists");
+    }
+
+    TreeStats stats;
+    const size_t per_directory = std::max<size_t>(spec.files_per_directory, 1);
+    const size_t directory_count = std::max<size_t>((spec.entries + per_directory - 1) / per_directory, 1);
+    const int depth = std::max(spec.depth, 0);
+
+    // Directory i > 0 hangs off directory (i - 1) / fanout, so the tree is
+    // complete and its height is about log_fanout(directory_count).
+    size_t fanout = directory_count;
+    if (depth > 0) {
+        fanout = static_cast<size_t>(std::ceil(std::pow(static_cast<double>(directory_count),
+                                                        1.0 / depth)));
+        fanout = std::max<size_t>(fanout, 2);
+    }
+
+    std::vector<fs::path> directories;
+    directories.reserve(directory_count);
+    fs::create_directories(root);
+    directories.push_back(root);
+    for (size_t i = 1; i < directory_count; ++i) {
+        const fs::path &parent = depth > 0 ? directories[(i - 1) / fanout] : root;
+        directories.push_back(parent / ("dir_" + std::to_string(i)));
+        fs::create_directory(directories.back());
+    }
+    // Entries beyond the first level count towards the total, as the scanner reports them.
+    stats.directories = directory_count - 1;
+
+    std::mt19937 rng(spec.seed);
+    std::uniform_real_distribution<double> roll(0.0, 1.0);
+    const size_t file_budget = spec.entries > stats.directories ? spec.entries - stats.directories : 0;
+
+    for (size_t n = 0; n < file_budget; ++n) {
+        const size_t dir_index = n % directory_count;
+        const fs::path &directory = directories[dir_index];
+        const size_t slot = n / directory_count;
+        const double kind = roll(rng);
+        const std::string base = "file_" + std::to_string(n);
+        const char *extension = kExtensions[n % std::size(kExtensions)];
+
+        if (kind < spec.junk_ratio) {
+            std::string name;
+            if (slot < std::size(kFixedJunk)) {
+                name = kFixedJunk[slot];
+            } else {
+                name = (n % 2 ? "~$" + base + ".docx" : base + ".part");
+            }
+            if (!fs::exists(directory / name)) {
+                create_file(directory / name);
+                ++stats.junk;
+                continue;
+            }
+        } else if (kind < spec.junk_ratio + spec.bundle_ratio) {
+            fs::path bundle = directory / ("App_" + std::to_string(n) + ".app");
+            fs::create_directories(bundle / "Contents");
+            create_file(bundle / "Contents" / "Info.plist");
+            ++stats.bundles;
+            continue;
+        } else if (kind < spec.junk_ratio + spec.bundle_ratio + spec.hidden_ratio) {
+            create_file(directory / ("." + base + "." + extension));
+            ++stats.hidden;
+            continue;
+        }
+
+        create_file(directory / (base + "." + extension));
+        ++stats.files;
+    }
+
+    return stats;
+}
@@ -0,0 +1,41 @@
+#ifndef TREE_GENERATOR_HPP
+#define TREE_GENERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Builds a synthetic directory tree for scanner benchmarks. Files are empty
+// and spread evenly over a tree of roughly entries / files_per_directory
+// directories, fanned out so that the deepest one sits `depth` levels below
+// the root. The same spec and seed always produce the same tree.
+struct TreeSpec {
+    size_t entries{100000};
+    int depth{4};
+    size_t files_per_directory{64};
+    double hidden_ratio{0.05};
+    double bundle_ratio{0.01};
+    double junk_ratio{0.01};
+    std::uint32_t seed{42};
+};
+
+struct TreeStats {
+    size_t directories{0};
+    size_t files{0};
+    size_t hidden{0};
+    size_t bundles{0};
+    size_t junk{0};
+};
+
+class TreeGenerator {
+public:
+    explicit TreeGenerator(TreeSpec spec) : spec(spec) {}
+
+    // root must not exist yet.
+    TreeStats generate(const std::filesystem::path &root) const;
+
+private:
+    TreeSpec spec;
+};
+
+#endif
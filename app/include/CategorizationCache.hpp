@@ -0,0 +1,50 @@
+#ifndef CATEGORIZATION_CACHE_HPP
+#define CATEGORIZATION_CACHE_HPP
+
+#include "Types.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// In-memory copy of file_categorization keyed by (file name, file type), so
+// that already categorized names are answered without a query. Entries live
+// in a vector; an open-addressing table with linear probing maps keys to
+// them and is kept at most half full.
+class CategorizationCache {
+public:
+    struct Entry {
+        std::string file_name;
+        FileType file_type;
+        std::string dir_path;
+        std::string category;
+        std::string subcategory;
+        int taxonomy_id;
+    };
+
+    void clear();
+    void reserve(size_t count);
+    // Keeps one entry per name and type: the one with the smallest dir_path,
+    // so the answer does not depend on the order rows are loaded or written.
+    void store(Entry entry);
+    const Entry *find(std::string_view file_name, FileType file_type) const;
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Slot {
+        std::uint64_t hash;
+        std::uint32_t entry;
+    };
+    static constexpr std::uint32_t kEmpty = UINT32_MAX;
+
+    static std::uint64_t hash(std::string_view file_name, FileType file_type);
+    // Index of the slot holding the key, or of the empty slot ending its probe.
+    size_t probe(std::uint64_t hash, std::string_view file_name, FileType file_type) const;
+    void rehash(size_t slot_count);
+
+    std::vector<Entry> entries;
+    std::vector<Slot> slots;
+};
+
+#endif
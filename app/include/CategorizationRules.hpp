@@ -0,0 +1,41 @@
+#ifndef CATEGORIZATION_RULES_HPP
+#define CATEGORIZATION_RULES_HPP
+
+#include "Types.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// Extension -> (category, subcategory) rules applied before the LLM. The
+// built-in table is a compile-time perfect hash; rules from
+// categorization_rules.ini in the config directory override it, e.g.
+//
+//   [Extensions]
+//   .iso = Disk images : Operating systems
+//   ; "-" sends .pdf files to the LLM again
+//   .pdf = -
+class CategorizationRules {
+public:
+    struct Rule {
+        std::string_view category;
+        std::string_view subcategory;
+    };
+
+    explicit CategorizationRules(const std::string &config_dir);
+
+    std::optional<Rule> match(std::string_view file_name, FileType file_type) const;
+    static std::optional<Rule> match_builtin(std::string_view extension);
+    size_t user_rule_count() const { return user_rules.size(); }
+
+private:
+    void load_user_rules(const std::string &rules_file);
+
+    // Lowercase extension without the dot -> (category, subcategory); an
+    // empty category disables the built-in rule for that extension.
+    std::unordered_map<std::string, std::pair<std::string, std::string>> user_rules;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef CONTENT_SNIFFER_HPP
+#define CONTENT_SNIFFER_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Identifies file formats from their leading bytes so the LLM sees more
+// than a file name for things like "scan0001" or extensionless downloads.
+// Descriptions are static strings; nullptr means the format is unknown.
+class ContentSniffer {
+public:
+    // Hard per-file I/O budget: a single read of at most this many bytes.
+    static constexpr size_t kMaxHeaderBytes = 4096;
+
+    static const char* sniff(const std::string &path);
+    static const char* identify(std::string_view header);
+
+private:
+    ContentSniffer() = delete;
+};
+
+#endif
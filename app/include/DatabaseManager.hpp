@@ -1,13 +1,27 @@
 #ifndef DATABASEMANAGER_HPP
 #define DATABASEMANAGER_HPP
 
+#include "CategorizationCache.hpp"
+#include "DatabaseWriter.hpp"
+#include "ReadConnectionPool.hpp"
+#include "TaxonomyIndex.hpp"
 #include "Types.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
-#include <map>
+#include <optional>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <sqlite3.h>
 
+class ScanSnapshotIndex;
+
+// Lookups, category resolution and categorization writes may be called from
+// several threads at once. A scan snapshot index is saved from one thread at
+// a time.
 class DatabaseManager {
 public:
     DatabaseManager(std::string config_dir);
@@ -27,15 +41,93 @@ public:
                                                    const std::string& file_type,
                                                    const std::string& dir_path,
                                                    const ResolvedCategory& resolved);
+
+    struct CategorizationRecord {
+        std::string file_name;
+        std::string file_type;
+        std::string dir_path;
+        ResolvedCategory resolved;
+    };
+
+    // Queues the records for the writer thread, which stores them all or
+    // none; returns false only if they could not be queued.
+    bool insert_or_update_files_with_categorization(const std::vector<CategorizationRecord>& records);
+    // Waits until every queued write is committed; false if any failed.
+    bool flush_writes();
     std::vector<std::string> get_dir_contents_from_db(const std::string &dir_path);
+    // Records a folder that sorting is about to create, so that scans and
+    // folder watches leave the files sorted into it alone.
+    void add_sort_destination(const std::string &path);
+    bool is_sort_destination(const std::string &path) const;
 
-    std::vector<CategorizedFile> get_categorized_files(const std::string &directory_path);
+    std::vector<CategorizedFile> get_categorized_files(const std::string &directory_path,
+                                                       bool include_subdirectories = false);
 
-    std::vector<std::string>
+    // Answered from an in-memory copy of file_categorization that is loaded
+    // on first use and updated by every queued write.
+    std::optional<ResolvedCategory>
         get_categorization_from_db(const std::string& file_name, const FileType file_type);
-    void increment_taxonomy_frequency(int taxonomy_id);
+    // Frequencies are kept up to date by triggers; this rebuilds them all
+    // from file_categorization. Returns the number of taxonomy rows updated,
+    // or -1 on failure.
+    int recompute_taxonomy_frequencies();
+
+    void load_scan_snapshot(const std::string &directory_path, bool include_subdirectories,
+                            ScanSnapshotIndex &index);
+    // Queues the listings updated since the last save for the writer
+    // thread; returns false only if they could not be queued.
+    bool save_scan_snapshot(ScanSnapshotIndex &index, bool prune_unvisited);
 
 private:
+    // Every query that runs per file or per directory is prepared once and
+    // kept until the connection closes.
+    enum class Statement {
+        SelectDirectoryFiles,
+        SelectSubtreeFiles,
+        SelectSnapshotDirectories,
+        SelectSnapshotEntries,
+        SelectDirContents,
+        FileExists,
+        Count
+    };
+
+    // Borrowed cached statement; resets it and clears its bindings when done.
+    class CachedStatement {
+    public:
+        explicit CachedStatement(sqlite3_stmt *stmt) : stmt(stmt) {}
+        ~CachedStatement();
+        CachedStatement(const CachedStatement &) = delete;
+        CachedStatement &operator=(const CachedStatement &) = delete;
+
+        sqlite3_stmt *get() const { return stmt; }
+        explicit operator bool() const { return stmt != nullptr; }
+
+    private:
+        sqlite3_stmt *stmt;
+    };
+
+    static const char *statement_sql(Statement id);
+    // On a pooled read-only connection; must not outlive the lease.
+    static CachedStatement statement(ReadConnectionPool::Lease &lease, Statement id);
+
+    // Rolls back on destruction unless commit() succeeded.
+    class Transaction {
+    public:
+        explicit Transaction(sqlite3 *db);
+        ~Transaction();
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+
+        bool is_open() const { return open; }
+        bool commit();
+
+    private:
+        sqlite3 *db;
+        bool open{false};
+    };
+
+    void configure_connection();
+
     struct TaxonomyEntry {
         int id;
         std::string category;
@@ -44,46 +136,95 @@ private:
         std::string normalized_subcategory;
     };
 
-    void initialize_schema();
-    void initialize_taxonomy_schema();
+    // The taxonomy as resolve_category sees it. A published snapshot is
+    // never modified: readers hold on to the one they loaded while new
+    // entries and aliases go into a copy that replaces it.
+    struct TaxonomySnapshot {
+        std::vector<TaxonomyEntry> entries;
+        std::unordered_map<std::string, int> canonical_lookup;
+        std::unordered_map<std::string, int> alias_lookup;
+        std::unordered_map<int, size_t> index;
+        TaxonomyIndex fuzzy_index;
+
+        void add(TaxonomyEntry entry);
+        const TaxonomyEntry* find(int taxonomy_id) const;
+    };
+
+    // Brings the schema up to date, one PRAGMA user_version step at a time.
+    void migrate_schema();
+    bool initialize_schema();
+    bool initialize_taxonomy_schema();
+    bool initialize_frequency_triggers();
+    bool initialize_scan_snapshot_schema();
+    bool initialize_lookup_indexes();
+    bool initialize_directory_schema();
+    bool drop_scan_entry_metadata();
+    bool initialize_sort_destination_schema();
+#ifndef NDEBUG
+    // Logs how SQLite runs each cached statement and flags full table scans.
+    void check_query_plans() const;
+#endif
     void load_taxonomy_cache();
+    void load_sort_destinations();
     std::string normalize_label(const std::string& input) const;
-    static double string_similarity(const std::string& a, const std::string& b);
     static std::string make_key(const std::string& norm_category,
                                 const std::string& norm_subcategory);
-    std::pair<int, double> find_fuzzy_match(const std::string& norm_category,
-                                            const std::string& norm_subcategory) const;
-    int resolve_existing_taxonomy(const std::string& key,
-                                   const std::string& norm_category,
-                                   const std::string& norm_subcategory) const;
-    ResolvedCategory build_resolved_category(int taxonomy_id,
-                                             const std::string& fallback_category,
-                                             const std::string& fallback_subcategory,
-                                             const std::string& norm_category,
-                                             const std::string& norm_subcategory);
+    static std::pair<int, double> find_fuzzy_match(const TaxonomySnapshot& taxonomy,
+                                                   const std::string& norm_category,
+                                                   const std::string& norm_subcategory);
+    static int resolve_existing_taxonomy(const TaxonomySnapshot& taxonomy,
+                                         const std::string& key,
+                                         const std::string& norm_category,
+                                         const std::string& norm_subcategory);
+    static bool needs_alias_mapping(const TaxonomySnapshot& taxonomy, int taxonomy_id,
+                                    const std::string& key);
+    static ResolvedCategory build_resolved_category(const TaxonomySnapshot& taxonomy,
+                                                    int taxonomy_id,
+                                                    const std::string& fallback_category,
+                                                    const std::string& fallback_subcategory);
+    // Adds the entry (when taxonomy_id is -1) and the alias the labels need,
+    // publishing one new snapshot; returns the snapshot that holds them.
+    std::shared_ptr<const TaxonomySnapshot> extend_taxonomy(int& taxonomy_id,
+                                                            const std::string& category,
+                                                            const std::string& subcategory,
+                                                            const std::string& norm_category,
+                                                            const std::string& norm_subcategory,
+                                                            const std::string& key);
     int create_taxonomy_entry(const std::string& category,
                               const std::string& subcategory,
                               const std::string& norm_category,
                               const std::string& norm_subcategory);
-    int find_existing_taxonomy_id(const std::string& norm_category,
-                                  const std::string& norm_subcategory) const;
-    void ensure_alias_mapping(int taxonomy_id,
-                              const std::string& norm_category,
-                              const std::string& norm_subcategory);
-    const TaxonomyEntry* find_taxonomy_entry(int taxonomy_id) const;
+    // Called by the writer for entries it could not store.
+    void drop_taxonomy_entries(const std::vector<int>& ids);
 
-    std::map<std::string, std::string> cached_results;
-    std::string get_cached_category(const std::string &file_name);
-    void load_cache();
+    // Loads the categorization cache on first use; false without a database.
+    bool ensure_categorization_cache();
+    void load_categorization_cache();
+    void cache_categorization(const std::string& file_name,
+                              const std::string& file_type,
+                              const std::string& dir_path,
+                              const ResolvedCategory& resolved);
     bool file_exists_in_db(const std::string &file_name, const std::string &file_path);
 
     sqlite3* db;
     const std::string config_dir;
     const std::string db_file;
-    std::vector<TaxonomyEntry> taxonomy_entries;
-    std::unordered_map<std::string, int> canonical_lookup;
-    std::unordered_map<std::string, int> alias_lookup;
-    std::unordered_map<int, size_t> taxonomy_index;
+    std::unique_ptr<ReadConnectionPool> readers;
+    // Only read and replaced through std::atomic_load/std::atomic_store;
+    // std::atomic<std::shared_ptr> is missing from libc++ and older libstdc++.
+    std::shared_ptr<const TaxonomySnapshot> taxonomy;
+    // Serializes taxonomy and alias additions; lookups never take it.
+    std::mutex taxonomy_mutex;
+    int next_taxonomy_id{0};  // guarded by taxonomy_mutex; 0 if unknown
+    std::shared_mutex categorization_mutex;
+    mutable std::shared_mutex sort_destinations_mutex;
+    std::unordered_set<std::string> sort_destinations;
+    CategorizationCache categorization_cache;
+    // Set once the cache is loaded, while categorization_mutex is held.
+    std::atomic<bool> categorization_cache_loaded{false};
+    // Categorization, taxonomy and scan snapshot writes. The main connection
+    // is left with schema setup; every other query runs on a pooled reader.
+    std::unique_ptr<DatabaseWriter> writer;
 };
 
 #endif
@@ -0,0 +1,129 @@
+#ifndef DATABASE_WRITER_HPP
+#define DATABASE_WRITER_HPP
+
+#include "BoundedQueue.hpp"
+#include "ScanSnapshot.hpp"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+#include <sqlite3.h>
+
+// Owns the connection that categorization and scan snapshot writes go through. Producers
+// queue requests and return at once; a background thread applies whatever
+// has queued up in one transaction, so neither the UI nor the analysis
+// thread waits for the disk. Producers only block while the queue is full.
+class DatabaseWriter {
+public:
+    struct FileRow {
+        std::string file_name;
+        std::string file_type;
+        std::string dir_path;
+        std::string category;
+        std::string subcategory;
+        int taxonomy_id;  // stored as NULL unless positive
+    };
+
+    // Runs on the writer thread with the ids of taxonomy entries that were
+    // not stored, either because the insert failed or because its
+    // transaction was rolled back.
+    using TaxonomyFailureCallback = std::function<void(const std::vector<int> &ids)>;
+
+    explicit DatabaseWriter(const std::string &db_file,
+                            TaxonomyFailureCallback on_taxonomy_failure = nullptr);
+    // Writes everything still queued before closing the connection.
+    ~DatabaseWriter();
+    DatabaseWriter(const DatabaseWriter &) = delete;
+    DatabaseWriter &operator=(const DatabaseWriter &) = delete;
+
+    bool is_open() const { return db != nullptr; }
+
+    // The rows of one call are written atomically. Returns false if the
+    // writer has stopped.
+    bool upsert_files(std::vector<FileRow> rows);
+    bool insert_alias(std::string norm_category, std::string norm_subcategory, int taxonomy_id);
+    // The caller allocates the id, so the entry can be used before it is
+    // written; requests queued after this one may refer to it.
+    bool insert_taxonomy(int id, std::string category, std::string subcategory,
+                         std::string norm_category, std::string norm_subcategory);
+    bool insert_sort_destination(std::string path);
+    // Replaces the stored listings of `listings` and drops those of `stale`,
+    // all or nothing.
+    bool save_scan_snapshot(std::vector<std::pair<std::string, ScanSnapshotIndex::SnapshotPtr>> listings,
+                            std::vector<std::string> stale);
+    // Waits until everything queued before the call has been committed.
+    // Returns false if any write failed since the previous flush.
+    bool flush();
+
+private:
+    struct FileBatch {
+        std::vector<FileRow> rows;
+    };
+    struct AliasInsert {
+        std::string norm_category;
+        std::string norm_subcategory;
+        int taxonomy_id;
+    };
+    struct TaxonomyInsert {
+        int id;
+        std::string category;
+        std::string subcategory;
+        std::string norm_category;
+        std::string norm_subcategory;
+    };
+    struct SortDestinationInsert {
+        std::string path;
+    };
+    struct ScanSnapshotSave {
+        std::vector<std::pair<std::string, ScanSnapshotIndex::SnapshotPtr>> listings;
+        std::vector<std::string> stale;
+    };
+    struct Barrier {
+        std::promise<bool> succeeded;
+    };
+    using Request = std::variant<FileBatch, AliasInsert, TaxonomyInsert,
+                                 SortDestinationInsert, ScanSnapshotSave, Barrier>;
+
+    void run();
+    void write_group(std::vector<Request> &group);
+    bool write_files(const FileBatch &batch);
+    bool write_alias(const AliasInsert &alias);
+    bool write_taxonomy(const TaxonomyInsert &taxonomy);
+    bool write_sort_destination(const SortDestinationInsert &destination);
+    bool write_scan_snapshot(const ScanSnapshotSave &save);
+    // Id of the directories row for the path, added if missing; 0 on failure.
+    sqlite3_int64 directory_id(const std::string &dir_path);
+    bool exec(const char *sql);
+    sqlite3_stmt *prepare(const char *sql);
+    void finalize_statements();
+
+    sqlite3 *db{nullptr};
+    sqlite3_stmt *upsert_file_stmt{nullptr};
+    sqlite3_stmt *insert_alias_stmt{nullptr};
+    sqlite3_stmt *insert_taxonomy_stmt{nullptr};
+    sqlite3_stmt *select_directory_stmt{nullptr};
+    sqlite3_stmt *insert_directory_stmt{nullptr};
+    sqlite3_stmt *insert_sort_destination_stmt{nullptr};
+    sqlite3_stmt *upsert_scan_directory_stmt{nullptr};
+    sqlite3_stmt *delete_scan_directory_stmt{nullptr};
+    sqlite3_stmt *delete_scan_entries_stmt{nullptr};
+    sqlite3_stmt *insert_scan_entry_stmt{nullptr};
+    BoundedQueue<Request> queue;
+    TaxonomyFailureCallback on_taxonomy_failure;
+    // File rows that refer to these ids are stored without one; aliases of
+    // them are not stored at all.
+    std::unordered_set<int> lost_taxonomy_ids;  // writer thread only
+    bool failed_since_flush{false};  // writer thread only
+    // Directory ids known to be committed or in the open transaction;
+    // cleared whenever a rollback may have removed some.
+    std::unordered_map<std::string, sqlite3_int64> directory_ids;  // writer thread only
+    std::thread thread;
+};
+
+#endif
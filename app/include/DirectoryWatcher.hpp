@@ -0,0 +1,83 @@
+#ifndef DIRECTORY_WATCHER_HPP
+#define DIRECTORY_WATCHER_HPP
+
+#include "FileScanner.hpp"
+#include "NameFilter.hpp"
+#include "PathTable.hpp"
+#include "Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Watches a folder for files that finish being written or are moved in, and
+// hands them over in batches once a burst of events has settled. Uses
+// inotify, so it is only available on Linux.
+class DirectoryWatcher {
+public:
+    // Runs on the watcher thread.
+    using BatchCallback = std::function<void(std::vector<FileEntry> &&entries)>;
+
+    explicit DirectoryWatcher(std::chrono::milliseconds debounce = std::chrono::milliseconds(500));
+    ~DirectoryWatcher();
+    DirectoryWatcher(const DirectoryWatcher &) = delete;
+    DirectoryWatcher &operator=(const DirectoryWatcher &) = delete;
+
+    static bool is_supported();
+    // Options and max_depth have the same meaning as for FileScanner.
+    bool start(const std::string &directory_path, FileScanOptions options,
+               int max_depth, BatchCallback on_batch,
+               std::shared_ptr<const NameFilter> filter = nullptr);
+    // Joins the watcher thread, which may be in the middle of a batch.
+    void stop();
+    // Asks the watcher thread to finish after its current batch, without
+    // waiting for it; stop() or start() joins it later.
+    void request_stop();
+    bool is_running() const;
+    // True while a stopped watcher thread is still finishing its batch.
+    bool is_stopping() const;
+    // Applies to watches started afterwards; new subdirectories it accepts
+    // are neither watched nor reported, like FileScanner's pruned ones.
+    void set_pruned_directories(FileScanner::DirectoryPredicate is_pruned);
+
+private:
+    struct WatchedDirectory {
+        std::string path;
+        int depth;
+    };
+
+    void run();
+    bool add_watch(const std::string &dir_path, int depth);
+    bool is_pruned(const std::string &dir_path) const;
+    void add_subdirectory_watches(const std::string &dir_path);
+    void handle_event(int wd, uint32_t mask, const char *name);
+    void queue_entry(const std::string &dir_path, std::string_view file_name, FileType type);
+    void flush_pending();
+    void close_descriptors();
+
+    const std::chrono::milliseconds debounce;
+    FileScanOptions options{FileScanOptions::None};
+    int max_depth{0};
+    std::shared_ptr<const NameFilter> filter;
+    FileScanner::DirectoryPredicate pruned_directories;
+    BatchCallback on_batch;
+    std::atomic<bool> running{false};
+    std::atomic<bool> exited{true};
+    std::thread worker;
+    int inotify_fd{-1};
+    int wake_fd{-1};
+    std::unordered_map<int, WatchedDirectory> watches;
+    // Each batch gets a fresh table, which is released once the batch is done.
+    std::shared_ptr<PathTable> paths;
+    StringArena *names{nullptr};
+    std::vector<FileEntry> pending;
+    std::unordered_set<std::string> pending_paths;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef EDIT_DISTANCE_HPP
+#define EDIT_DISTANCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Levenshtein distance over bytes, computed with the bit-parallel algorithm
+// of Myers (in Hyyrö's formulation): one machine word holds a column of the
+// DP matrix for up to 64 pattern characters, longer patterns use a block of
+// words. Scratch space is per thread and reused, so calls do not allocate
+// once it has grown to the longest label seen.
+class EditDistance {
+public:
+    static constexpr size_t kUnbounded = SIZE_MAX;
+
+    // Returns the distance, or max_distance + 1 as soon as the distance is
+    // known to exceed max_distance.
+    static size_t levenshtein(std::string_view a, std::string_view b,
+                              size_t max_distance = kUnbounded);
+
+    // 1 - distance / longer length, 1.0 for equal strings and 0.0 if either
+    // is empty. Returns 0.0 without finishing the computation once the
+    // result is known to fall below min_similarity.
+    static double similarity(std::string_view a, std::string_view b,
+                             double min_similarity = 0.0);
+
+private:
+    static size_t single_word(std::string_view pattern, std::string_view text,
+                              size_t max_distance);
+    static size_t multi_word(std::string_view pattern, std::string_view text,
+                             size_t max_distance);
+};
+
+#endif
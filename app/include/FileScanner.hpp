@@ -2,23 +2,71 @@
 #define FILE_SCANNER_HPP
 
 #include <filesystem>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "Types.hpp"
 
+class NameFilter;
+class ScanSnapshotIndex;
+class StringArena;
+
 namespace fs = std::filesystem;
 
 class FileScanner {
 public:
+    // Receives each entry as soon as its directory has been read; returning
+    // false stops the scan. Calls are serialized, even for recursive scans.
+    using EntryCallback = std::function<bool(FileEntry &&entry)>;
+    // Called with the full path of a subdirectory, possibly from several
+    // threads at once; true keeps a recursive scan out of it.
+    using DirectoryPredicate = std::function<bool(const std::string &path)>;
+
     FileScanner() = default;
+
+    // With FileScanOptions::Recursive, subdirectories are scanned in parallel
+    // down to max_depth levels below directory_path (0 means no limit).
     std::vector<FileEntry>
         get_directory_entries(const std::string &directory_path,
-                              FileScanOptions options);
+                              FileScanOptions options,
+                              int max_depth = 0);
+    // With a snapshot index, directories whose inode and mtime match the
+    // stored listing are not read again, and fresh listings are recorded.
+    // Returns false if on_entry stopped the scan.
+    bool scan_directory_entries(const std::string &directory_path,
+                                FileScanOptions options,
+                                const EntryCallback &on_entry,
+                                int max_depth = 0,
+                                ScanSnapshotIndex *snapshot = nullptr);
+    void set_thread_count(unsigned int count);
+    // Applies to scans started afterwards; excluded directories are pruned.
+    void set_name_filter(std::shared_ptr<const NameFilter> filter);
+    // Recursive scans do not descend into the subdirectories it accepts,
+    // such as the category folders that sorting created.
+    void set_pruned_directories(DirectoryPredicate is_pruned);
+    static bool is_junk_file(std::string_view name);
+    static bool is_file_bundle(std::string_view name);
 
 private:
-    bool is_file_hidden(const fs::path &path);
-    bool is_junk_file(const std::string& name);
-    bool is_file_bundle(const fs::path& path);
+    struct ScanTask {
+        fs::path path;
+        int depth;
+    };
+    struct ScanContext;
+
+    void scan_directory(const fs::path &directory, int depth,
+                        ScanContext &context,
+                        StringArena &names,
+                        std::vector<FileEntry> &batch,
+                        std::vector<ScanTask> &subdirectories);
+    void scan_recursive(std::vector<ScanTask> subdirectories,
+                        ScanContext &context);
+
+    unsigned int thread_count{0};
+    std::shared_ptr<const NameFilter> name_filter;
+    DirectoryPredicate pruned_directories;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,11 +1,35 @@
 #pragma once
 #include "Types.hpp"
+#include <cstddef>
 #include <string>
+#include <vector>
+
+struct LLMRequest {
+    std::string file_name;
+    std::string file_path;
+    std::string content_type;
+    FileType file_type;
+};
 
 class ILLMClient {
 public:
     virtual ~ILLMClient() = default;
     virtual std::string categorize_file(const std::string& file_name,
                                         const std::string& file_path,
+                                        const std::string& content_type,
                                         FileType file_type) = 0;
+
+    // How many requests categorize_batch handles at once to advantage.
+    virtual size_t max_batch_size() const { return 1; }
+    // One answer per request, in order. Clients that cannot batch answer
+    // the requests one by one.
+    virtual std::vector<std::string> categorize_batch(const std::vector<LLMRequest>& requests) {
+        std::vector<std::string> answers;
+        answers.reserve(requests.size());
+        for (const auto& request : requests) {
+            answers.push_back(categorize_file(request.file_name, request.file_path,
+                                              request.content_type, request.file_type));
+        }
+        return answers;
+    }
 };
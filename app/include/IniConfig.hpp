@@ -12,6 +12,7 @@ public:
     bool load(const std::string &filename);
     std::string getValue(const std::string &section, const std::string &key, const std::string &default_value = "") const;
     void setValue(const std::string &section, const std::string &key, const std::string &value);
+    const std::map<std::string, std::string> *getSection(const std::string &section) const;
     bool save(const std::string &filename) const;
 
 private:
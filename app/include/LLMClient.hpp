@@ -11,6 +11,7 @@ public:
     ~LLMClient() override;
     std::string categorize_file(const std::string& file_name,
                                 const std::string& file_path,
+                                const std::string& content_type,
                                 FileType file_type) override;
 
 private:
@@ -18,6 +19,7 @@ private:
     std::string send_api_request(std::string json_payload);
     std::string make_payload(const std::string &file_name,
                              const std::string &file_path,
+                             const std::string &content_type,
                              const FileType file_type);
 };
 
@@ -3,29 +3,74 @@
 #include "ILLMClient.hpp"
 #include "Types.hpp"
 #include "llama.h"
+#include <mutex>
 #include <string>
+#include <vector>
 
 class LocalLLMClient : public ILLMClient {
 public:
-    explicit LocalLLMClient(const std::string& model_path);
+    // With persist_prompt_cache, the decoded instruction prefix is kept in
+    // a state file next to the model and loaded instead of decoded.
+    explicit LocalLLMClient(const std::string& model_path, bool persist_prompt_cache = false);
     ~LocalLLMClient();
 
+    // Picks the GPU layer count and sets the environment llama.cpp reads
+    // for it, once per process. setenv is not safe while other threads may
+    // read the environment, so call this on the main thread before a client
+    // is created elsewhere; the constructor only does it if nobody has.
+    static void prepare_environment();
+
     std::string make_prompt(const std::string& file_name,
                             const std::string& file_path,
+                            const std::string& content_type,
                             FileType file_type);
     std::string generate_response(const std::string &prompt, int n_predict);
+    // Generates the answers of several prompts together, each in its own
+    // sequence of the context; answers are in prompt order.
+    std::vector<std::string> generate_responses(const std::vector<std::string> &prompts,
+                                                int n_predict);
     std::string categorize_file(const std::string& file_name,
                                 const std::string& file_path,
+                                const std::string& content_type,
                                 FileType file_type) override;
+    size_t max_batch_size() const override;
+    std::vector<std::string> categorize_batch(const std::vector<LLMRequest>& requests) override;
 
 private:
     void load_model_if_needed();
+    // Frees the samplers, context and model.
+    void release();
+    std::vector<llama_token> tokenize_prompt(const std::string& prompt);
+    // Appends the tokens to the context and to cached_tokens; on failure
+    // the context is cleared.
+    bool decode_tokens(const llama_token* tokens, size_t count);
+    // Decodes the instruction prefix every prompt starts with, or loads it
+    // from the prompt cache file.
+    void warm_up_prompt_cache();
+    bool load_prompt_cache(const std::vector<llama_token>& prefix);
+    // Decodes the prompts of group, which share their first n_common
+    // tokens, side by side and appends each answer to its output.
+    bool generate_group(const std::vector<size_t>& group,
+                        const std::vector<std::vector<llama_token>>& tokens,
+                        size_t n_common, int n_predict,
+                        std::vector<std::string>& outputs);
+
+    // Decided by prepare_environment().
+    static int gpu_layers;
 
     std::string model_path;
-    llama_model* model;
-    llama_context* ctx;
-    const llama_vocab *vocab;
-    llama_sampler* smpl;
-    std::string sanitize_output(std::string &output);
+    llama_model* model{nullptr};
+    // Created with the model and reused by every request.
+    llama_context* ctx{nullptr};
+    const llama_vocab *vocab{nullptr};
+    llama_sampler* smpl{nullptr};
+    // smpl followed by its clones, one per sequence.
+    std::vector<llama_sampler*> samplers;
+    std::mutex generation_mutex;
+    // The tokens whose state sequence 0 of the context holds, in order.
+    // Requests keep the prefix they share with it.
+    std::vector<llama_token> cached_tokens;
+    std::string prompt_cache_path;
+    void sanitize_output(std::string &output);
     llama_context_params ctx_params;
 };
@@ -0,0 +1,65 @@
+#ifndef LOCAL_MODEL_MANAGER_HPP
+#define LOCAL_MODEL_MANAGER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+class LocalLLMClient;
+
+// Keeps one local model loaded between analyses, so only the first request
+// pays for reading the GGUF file and setting up the backend. Callers get
+// shared handles to the resident client; once the last handle is gone the
+// model stays loaded until it has been idle for the configured time or the
+// system runs low on memory. A background thread can load the model ahead
+// of the first request. Destroying the manager waits for handles still held,
+// such as one kept by a request that timed out but is still generating.
+class LocalModelManager {
+public:
+    LocalModelManager();
+    ~LocalModelManager();
+    LocalModelManager(const LocalModelManager &) = delete;
+    LocalModelManager &operator=(const LocalModelManager &) = delete;
+
+    // The resident client for model_path, loading it first if needed (or
+    // waiting for a load in progress). Throws if the model cannot be loaded.
+    std::shared_ptr<LocalLLMClient> acquire(const std::string &model_path,
+                                            bool persist_prompt_cache);
+    // Starts loading model_path in the background, unless it is resident.
+    void preload(const std::string &model_path, bool persist_prompt_cache);
+    // Zero keeps an unused model loaded until memory runs low.
+    void set_idle_timeout(std::chrono::minutes timeout);
+
+private:
+    struct Resident;
+    struct PreloadRequest {
+        std::string model_path;
+        bool persist_prompt_cache;
+    };
+
+    std::shared_ptr<LocalLLMClient> load(std::unique_lock<std::mutex> &lock,
+                                         const std::string &model_path,
+                                         bool persist_prompt_cache);
+    std::shared_ptr<LocalLLMClient> make_handle(const std::shared_ptr<Resident> &resident);
+    void unload(std::unique_lock<std::mutex> &lock, const char *reason);
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::shared_ptr<Resident> resident;
+    // Set while a thread is loading a model; others wait rather than load
+    // a second copy.
+    bool loading{false};
+    // Handles not yet released, including those of a replaced model.
+    size_t outstanding_handles{0};
+    std::optional<PreloadRequest> preload_request;
+    std::chrono::minutes idle_timeout{10};
+    bool stopping{false};
+    std::thread worker;
+};
+
+#endif
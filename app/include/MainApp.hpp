@@ -3,9 +3,13 @@
 
 #include "CategorizationDialog.hpp"
 #include "CategorizationProgressDialog.hpp"
+#include "CategorizationRules.hpp"
 #include "DatabaseManager.hpp"
+#include "DirectoryWatcher.hpp"
 #include "FileScanner.hpp"
 #include "ILLMClient.hpp"
+#include "LocalModelManager.hpp"
+#include "NameFilter.hpp"
 #include "Settings.hpp"
 
 #include <gtk/gtk.h>
@@ -13,12 +17,14 @@
 #include <gtkmm/dialog.h>
 #include <gtkmm/treeview.h>
 #include <gtkmm/liststore.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <spdlog/logger.h>
 #include <string>
 #include <thread>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 
 struct CheckboxData {
@@ -33,7 +39,6 @@ public:
     GtkTreeView *treeview;
     std::vector<CategorizedFile> already_categorized_files;
     std::vector<CategorizedFile> new_files_with_categories;
-    std::vector<FileEntry> files_to_categorize;
     std::vector<CategorizedFile> new_files_to_sort;
 
     CategorizationProgressDialog* progress_dialog;
@@ -47,7 +52,7 @@ public:
     void show_error_dialog(const std::string &message);
 
     std::thread analyze_thread;
-    bool stop_analysis;
+    std::atomic<bool> stop_analysis;
 
     struct AnalysisContext {
         MainApp* app;
@@ -69,8 +74,10 @@ private:
     GtkWidget* main_window;
     Settings& settings;
     DatabaseManager db_manager;
+    CategorizationRules categorization_rules;
     CategorizationDialog* categorization_dialog;
     FileScanner dirscanner;
+    std::shared_ptr<const NameFilter> name_filter;
     GtkEntry* path_entry;
     GtkFileChooserWidget *file_chooser;
     GtkCheckButton *use_subcategories_checkbox;
@@ -82,10 +89,31 @@ private:
     CheckboxData* data_for_files = nullptr;
     CheckboxData* data_for_directories = nullptr;
     bool using_local_llm{false};
+    // Declared before every holder of a client it hands out.
+    LocalModelManager model_manager;
+    DirectoryWatcher directory_watcher;
+    // Set when watch mode is turned off; the analysis has stop_analysis.
+    std::atomic<bool> watch_cancelled{false};
+    // Serializes analysis and watch groups, which share the database. Held
+    // for one group at a time, so neither waits for a whole run.
+    std::mutex categorization_mutex;
 
+    // The cached or rule-based category of the item, if it has one.
+    std::optional<DatabaseManager::ResolvedCategory>
+    categorize_without_llm(const std::string& item_name,
+                           const std::string& item_path,
+                           const FileType file_type,
+                           const std::function<void(const std::string&)>& report_progress);
     DatabaseManager::ResolvedCategory
-    categorize_file(ILLMClient& llm, const std::string& item_name,
+    resolve_llm_answer(const std::string& item_name,
+                       const std::string& item_path,
+                       const std::string& category_subcategory,
+                       const std::function<void(const std::string&)>& report_progress);
+    // llm may be null when categorization_rules matches the item.
+    DatabaseManager::ResolvedCategory
+    categorize_file(const std::shared_ptr<ILLMClient>& llm, const std::string& item_name,
                     const std::string& item_path,
+                    const std::string& content_type,
                     const FileType file_type,
                     const std::function<void(const std::string&)>& report_progress);
     GtkApplication *create_app();
@@ -96,14 +124,27 @@ private:
     void ensure_one_checkbox(GtkCheckButton *checkbox, GtkCheckButton *other_checkbox);
     void update_file_scan_options(FileScanOptions option, bool is_active);
     void update_checkbox_settings(GtkCheckButton *checkbox);
-    std::unordered_set<std::string> extract_file_names(const std::vector<CategorizedFile> &categorized_files);
+    std::unordered_map<std::string, size_t> index_categorized_files(const std::vector<CategorizedFile> &categorized_files);
+    FileScanOptions current_scan_options() const;
     void on_activate();
     void initialize_builder();
     void setup_main_window();
     void initialize_ui_components();
-    std::unique_ptr<ILLMClient> make_llm_client();
+    std::shared_ptr<ILLMClient> make_llm_client();
+    std::string local_model_path() const;
+    void preload_local_model();
+    // cancelled is stop_analysis or watch_cancelled, whichever run asks.
     std::optional<CategorizedFile> categorize_single_file(
-        ILLMClient& llm, const FileEntry& entry);
+        const std::shared_ptr<ILLMClient>& llm, const FileEntry& entry,
+        const std::atomic<bool>& cancelled);
+    // One result per entry, in order; a local client answers the entries
+    // that need it in one batch.
+    std::vector<std::optional<CategorizedFile>> categorize_entries(
+        const std::shared_ptr<ILLMClient>& llm, const std::vector<FileEntry>& entries,
+        const std::atomic<bool>& cancelled);
+    std::optional<CategorizedFile> to_categorized_file(
+        const FileEntry& entry, const DatabaseManager::ResolvedCategory& resolved);
+    bool needs_llm(const FileEntry& entry);
     void start_updater();
     void on_about_activate();
     void on_donate_activate();
@@ -114,20 +155,29 @@ private:
     static void on_activate_wrapper(GtkApplication *gtk_app, gpointer user_data);
     std::string get_folder_path();
     std::vector<CategorizedFile>
-        categorize_files(const std::vector<FileEntry>& files);
-    std::string categorize_with_timeout(ILLMClient &llm, const std::string &item_name,
+        categorize_streamed_files(const std::string& directory_path);
+    // The request keeps running on a detached thread after a timeout; the
+    // client stays alive until it returns.
+    std::string categorize_with_timeout(std::shared_ptr<ILLMClient> llm,
+                                        const std::string &item_name,
                                         const std::string &item_path,
+                                        const std::string &content_type,
                                         const FileType file_type, int timeout_seconds);
-    std::vector<FileEntry> find_files_to_categorize(
-        const std::string& directory_path, const std::unordered_set<std::string>& cached_files);
+    std::vector<std::string> categorize_batch_with_timeout(std::shared_ptr<ILLMClient> llm,
+                                                           std::vector<LLMRequest> requests,
+                                                           int timeout_seconds);
     static void on_analyze_button_clicked(GtkButton *button, gpointer user_data);
     void perform_analysis();
     void setup_menu_item_file_explorer();
+    void setup_menu_item_watch_folder();
+    static void on_toggle_watch_folder(GtkCheckMenuItem *menu_item, gpointer user_data);
+    bool start_watching();
+    void stop_watching();
+    void categorize_watched_files(std::vector<FileEntry>&& entries);
     static void on_directory_selected(GtkFileChooser *file_chooser, gpointer user_data);
     static void on_toggle_file_explorer(GtkCheckMenuItem *menu_item, GtkWidget *directory_browser);
     static void on_path_entry_activate(GtkEntry *path_entry, gpointer user_data);
     std::vector<FileEntry> get_actual_files(const std::string &directory_path);
-    std::vector<CategorizedFile> compute_files_to_sort();
     gboolean update_ui_after_analysis();
     void sync_ui_to_settings();
     void sync_settings_to_ui();
@@ -13,6 +13,9 @@ public:
                     const std::string& file_name,
                     const std::string& file_type);
     ~MovableCategorizedFile();
+    // The outermost directory create_cat_dirs() would create; empty if
+    // both already exist.
+    std::filesystem::path missing_cat_dir(bool use_subcategory) const;
     void create_cat_dirs(bool use_subcategory);
     bool move_file(bool use_subcategory);
 
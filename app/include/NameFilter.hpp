@@ -0,0 +1,44 @@
+#ifndef NAME_FILTER_HPP
+#define NAME_FILTER_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// User-configured include/exclude patterns for entry names, compiled into a
+// single DFA so that a name is checked against all patterns in one pass.
+//
+// Patterns are globs matched against the whole name (not the path), case
+// sensitively: '*' matches any run of characters, '?' one character,
+// "[abc]", "[a-z]" and "[!abc]" a character set, and '\' escapes the next
+// character. Excluded directories are not descended into. Include patterns,
+// if any, only restrict files; directories are still traversed.
+class NameFilter {
+public:
+    NameFilter() = default;
+    NameFilter(const std::vector<std::string> &exclude_patterns,
+               const std::vector<std::string> &include_patterns);
+
+    bool is_excluded(std::string_view name) const { return evaluate(name) & kExclude; }
+    bool accepts_file(std::string_view name) const;
+    bool accepts_directory(std::string_view name) const { return !is_excluded(name); }
+    bool empty() const { return transitions.empty(); }
+    size_t state_count() const { return accepting.size(); }
+
+private:
+    static constexpr std::uint8_t kExclude = 1;
+    static constexpr std::uint8_t kInclude = 2;
+    using StateId = std::uint32_t;
+
+    std::uint8_t evaluate(std::string_view name) const;
+
+    std::array<std::uint8_t, 256> byte_class{};
+    size_t class_count{0};
+    std::vector<StateId> transitions;
+    std::vector<std::uint8_t> accepting;
+    bool has_include{false};
+};
+
+#endif
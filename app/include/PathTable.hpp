@@ -0,0 +1,68 @@
+#ifndef PATH_TABLE_HPP
+#define PATH_TABLE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Append-only string storage. Stored strings never move, so the returned
+// views stay valid for the arena's lifetime. Not thread-safe; give each
+// thread its own arena.
+class StringArena {
+public:
+    explicit StringArena(size_t block_size = 64 * 1024);
+    StringArena(const StringArena &) = delete;
+    StringArena &operator=(const StringArena &) = delete;
+
+    std::string_view store(std::string_view text);
+    size_t bytes_reserved() const { return reserved; }
+
+private:
+    const size_t block_size;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *cursor{nullptr};
+    size_t remaining{0};
+    size_t reserved{0};
+};
+
+
+// Shared storage for the paths of one scan: every directory is stored once
+// and entries refer to it by id, keeping only their own name. Interning
+// takes a lock; looking up an id that was handed to another thread through
+// a synchronized queue or lock does not.
+class PathTable {
+public:
+    using DirId = std::uint32_t;
+
+    PathTable();
+    PathTable(const PathTable &) = delete;
+    PathTable &operator=(const PathTable &) = delete;
+
+    DirId intern_directory(std::string_view dir_path);
+    std::string_view directory(DirId id) const;
+    size_t directory_count() const;
+
+    // Name storage for one thread, owned by the table.
+    StringArena &make_arena();
+
+private:
+    static constexpr size_t kSegmentSize = 4096;
+    static constexpr size_t kMaxSegments = 4096;
+    using Segment = std::array<std::string_view, kSegmentSize>;
+
+    mutable std::mutex mutex;
+    StringArena directory_storage;
+    std::unordered_map<std::string_view, DirId> directory_ids;
+    std::array<std::unique_ptr<Segment>, kMaxSegments> segments;
+    std::atomic<DirId> count{0};
+    std::deque<StringArena> arenas;
+};
+
+#endif
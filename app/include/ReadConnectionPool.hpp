@@ -0,0 +1,60 @@
+#ifndef READ_CONNECTION_POOL_HPP
+#define READ_CONNECTION_POOL_HPP
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+
+// Read-only connections for lookups that may run on several threads at
+// once. Under WAL each connection reads its own consistent view without
+// blocking the others or the writer. A thread leases a connection for the
+// duration of a query; connections are opened on demand, so the pool grows
+// to the number of threads that query at the same time, and are kept with
+// their prepared statements for the next lease.
+class ReadConnectionPool {
+    struct Connection;
+
+public:
+    class Lease {
+    public:
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&) = delete;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease();
+
+        explicit operator bool() const { return connection != nullptr; }
+        sqlite3 *db() const;
+        // Statement `slot` of this connection, prepared from sql on first
+        // use. The caller resets it before the lease ends.
+        sqlite3_stmt *statement(size_t slot, const char *sql);
+
+    private:
+        friend class ReadConnectionPool;
+        Lease(ReadConnectionPool *pool, std::unique_ptr<Connection> connection);
+
+        ReadConnectionPool *pool;
+        std::unique_ptr<Connection> connection;
+    };
+
+    ReadConnectionPool(std::string db_file, size_t statement_slots);
+    ~ReadConnectionPool();
+    ReadConnectionPool(const ReadConnectionPool &) = delete;
+    ReadConnectionPool &operator=(const ReadConnectionPool &) = delete;
+
+    // An idle connection, or a new one; an empty lease if it cannot be opened.
+    Lease acquire();
+
+private:
+    std::unique_ptr<Connection> open_connection() const;
+    void release(std::unique_ptr<Connection> connection);
+
+    const std::string db_file;
+    const size_t statement_slots;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Connection>> idle;
+};
+
+#endif
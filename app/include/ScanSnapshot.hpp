@@ -0,0 +1,58 @@
+#ifndef SCAN_SNAPSHOT_HPP
+#define SCAN_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class ScanEntryKind : std::uint8_t { Regular = 0, Directory = 1, Other = 2 };
+
+struct SnapshotEntry {
+    std::string name;
+    ScanEntryKind kind;
+    bool is_symlink;
+    bool is_hidden;
+};
+
+struct DirectorySnapshot {
+    std::uint64_t inode{0};
+    std::int64_t mtime_ns{0};
+    std::int64_t scanned_at_ns{0};
+    std::vector<SnapshotEntry> entries;
+};
+
+// Directory listings remembered from earlier scans, keyed by directory path.
+// The scanner replays a listing instead of reading the directory again when
+// the directory's inode and mtime are unchanged. Safe to share between the
+// scanner's worker threads.
+class ScanSnapshotIndex {
+public:
+    using SnapshotPtr = std::shared_ptr<const DirectorySnapshot>;
+
+    SnapshotPtr find(const std::string &dir_path) const;
+    // Adds a listing read from storage; it is not written back unless updated.
+    void load(std::string dir_path, DirectorySnapshot snapshot);
+    // Records a freshly read listing and marks it for saving.
+    void update(std::string dir_path, DirectorySnapshot snapshot);
+    void mark_visited(const std::string &dir_path);
+
+    std::vector<std::pair<std::string, SnapshotPtr>> take_dirty();
+    std::vector<std::string> unvisited_directories() const;
+    size_t size() const;
+
+private:
+    struct Slot {
+        SnapshotPtr snapshot;
+        bool dirty{false};
+        bool visited{false};
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Slot> directories;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <Types.hpp>
 #include <string>
 #include <filesystem>
+#include <vector>
 
 
 class Settings
@@ -31,6 +32,34 @@ public:
     std::string get_sort_folder() const;
     void set_sort_folder(const std::string &path);
 
+    bool get_recursive_scan() const;
+    void set_recursive_scan(bool value);
+
+    int get_max_scan_depth() const;
+    void set_max_scan_depth(int depth);
+
+    bool get_content_sniffing() const;
+    void set_content_sniffing(bool value);
+
+    // Whether the local LLM keeps its decoded instruction prefix on disk.
+    bool get_persist_prompt_cache() const;
+    void set_persist_prompt_cache(bool value);
+
+    // Whether the local model is loaded in the background at startup.
+    bool get_preload_local_model() const;
+    void set_preload_local_model(bool value);
+
+    // Minutes an unused local model stays loaded; 0 keeps it loaded.
+    int get_local_model_idle_minutes() const;
+    void set_local_model_idle_minutes(int minutes);
+
+    // Glob patterns for entry names, see NameFilter.
+    std::vector<std::string> get_exclude_patterns() const;
+    void set_exclude_patterns(const std::vector<std::string> &patterns);
+
+    std::vector<std::string> get_include_patterns() const;
+    void set_include_patterns(const std::vector<std::string> &patterns);
+
     std::string define_config_path();
     std::string get_config_dir();
 
@@ -48,6 +77,14 @@ private:
     bool categorize_directories;
     const char *default_sort_folder;
     std::string sort_folder;
+    bool recursive_scan;
+    int max_scan_depth;
+    bool content_sniffing;
+    bool persist_prompt_cache;
+    bool preload_local_model;
+    int local_model_idle_minutes;
+    std::vector<std::string> exclude_patterns;
+    std::vector<std::string> include_patterns;
     std::string skipped_version;
 };
 
@@ -0,0 +1,57 @@
+#ifndef TAXONOMY_INDEX_HPP
+#define TAXONOMY_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Trigram inverted index over normalized (category, subcategory) pairs,
+// used to narrow fuzzy taxonomy matching down to a few candidates.
+//
+// With both labels padded, an edit touches at most three trigrams, so
+// shared trigrams give a lower bound on the edit distance and therefore an
+// upper bound on DatabaseManager's similarity score. Entries whose bound
+// falls below the threshold are never scored, so the outcome matches a
+// full scan.
+class TaxonomyIndex {
+public:
+    struct Candidate {
+        size_t entry;
+        double upper_bound;
+    };
+
+    void clear();
+    // entry is the caller's index for this pair; entries are added in order.
+    void add(size_t entry, std::string_view norm_category, std::string_view norm_subcategory);
+    size_t size() const { return lengths.size(); }
+
+    // Entries sharing no trigram with one of the labels are never returned;
+    // they score below this, so thresholds must be above it.
+    static constexpr double kMinThreshold = 5.0 / 6.0;
+
+    // Entries whose averaged category/subcategory similarity may reach
+    // threshold, highest upper bound first.
+    std::vector<Candidate> candidates(std::string_view norm_category,
+                                      std::string_view norm_subcategory,
+                                      double threshold) const;
+
+private:
+    using Trigram = std::uint32_t;
+    struct Posting {
+        std::uint32_t entry;
+        std::uint32_t count;
+    };
+    using Postings = std::unordered_map<Trigram, std::vector<Posting>>;
+
+    static std::vector<std::pair<Trigram, std::uint32_t>> trigrams(std::string_view label);
+    static double similarity_bound(size_t query_length, size_t entry_length, size_t common);
+
+    Postings category_postings;
+    Postings subcategory_postings;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> lengths;
+};
+
+#endif
@@ -1,7 +1,12 @@
 #ifndef TYPES_HPP
 #define TYPES_HPP
 
+#include "PathTable.hpp"
+
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <string_view>
 
 enum class LLMChoice {
     Unset,
@@ -29,17 +34,41 @@ inline std::string to_string(FileType type) {
     }
 }
 
+// One scan result. The directory and name live in the shared PathTable of
+// the scan, so an entry is a few words regardless of path length.
 struct FileEntry {
-    std::string full_path;
-    std::string file_name;
-    FileType type;
+    std::shared_ptr<const PathTable> paths;
+    PathTable::DirId dir_id{0};
+    std::string_view file_name;
+    FileType type{FileType::File};
+    // Static description from ContentSniffer, or nullptr if not sniffed.
+    const char *content_type{nullptr};
+
+    std::string_view directory() const { return paths->directory(dir_id); }
+
+    void append_full_path(std::string &out) const {
+        std::string_view dir = directory();
+        out.append(dir);
+        if (!dir.empty() && dir.back() != static_cast<char>(std::filesystem::path::preferred_separator)) {
+            out.push_back(static_cast<char>(std::filesystem::path::preferred_separator));
+        }
+        out.append(file_name);
+    }
+
+    std::string full_path() const {
+        std::string path;
+        path.reserve(directory().size() + file_name.size() + 1);
+        append_full_path(path);
+        return path;
+    }
 };
 
 enum class FileScanOptions {
     None        = 0,
     Files       = 1 << 0,   // 0001
     Directories = 1 << 1,   // 0010
-    HiddenFiles = 1 << 2    // 0100
+    HiddenFiles = 1 << 2,   // 0100
+    Recursive   = 1 << 3    // 1000
 };
 
 inline bool has_flag(FileScanOptions value, FileScanOptions flag) {
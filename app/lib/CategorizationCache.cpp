@@ -0,0 +1,106 @@
+#include "CategorizationCache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <utility>
+
+namespace {
+
+constexpr size_t kMinSlots = 64;
+
+} // namespace
+
+
+void CategorizationCache::clear()
+{
+    entries.clear();
+    slots.clear();
+}
+
+
+void CategorizationCache::reserve(size_t count)
+{
+    entries.reserve(count);
+    if (count * 2 > slots.size()) {
+        rehash(std::bit_ceil(std::max(count * 2, kMinSlots)));
+    }
+}
+
+
+void CategorizationCache::store(Entry entry)
+{
+    if ((entries.size() + 1) * 2 > slots.size()) {
+        rehash(std::max(slots.size() * 2, kMinSlots));
+    }
+
+    const std::uint64_t key_hash = hash(entry.file_name, entry.file_type);
+    Slot &slot = slots[probe(key_hash, entry.file_name, entry.file_type)];
+    if (slot.entry != kEmpty) {
+        Entry &existing = entries[slot.entry];
+        if (entry.dir_path <= existing.dir_path) {
+            existing = std::move(entry);
+        }
+        return;
+    }
+
+    slot = {key_hash, static_cast<std::uint32_t>(entries.size())};
+    entries.push_back(std::move(entry));
+}
+
+
+const CategorizationCache::Entry *
+CategorizationCache::find(std::string_view file_name, FileType file_type) const
+{
+    if (slots.empty()) {
+        return nullptr;
+    }
+    const Slot &slot = slots[probe(hash(file_name, file_type), file_name, file_type)];
+    return slot.entry == kEmpty ? nullptr : &entries[slot.entry];
+}
+
+
+std::uint64_t CategorizationCache::hash(std::string_view file_name, FileType file_type)
+{
+    // Linear probing uses the low bits, so mix the string hash thoroughly.
+    std::uint64_t h = std::hash<std::string_view>{}(file_name);
+    h ^= file_type == FileType::Directory ? 0x9e3779b97f4a7c15ULL : 0;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+
+size_t CategorizationCache::probe(std::uint64_t key_hash, std::string_view file_name,
+                                  FileType file_type) const
+{
+    const size_t mask = slots.size() - 1;
+    for (size_t i = key_hash & mask;; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if (slot.entry == kEmpty) {
+            return i;
+        }
+        if (slot.hash == key_hash) {
+            const Entry &entry = entries[slot.entry];
+            if (entry.file_type == file_type && entry.file_name == file_name) {
+                return i;
+            }
+        }
+    }
+}
+
+
+void CategorizationCache::rehash(size_t slot_count)
+{
+    slots.assign(slot_count, {0, kEmpty});
+    const size_t mask = slot_count - 1;
+    for (std::uint32_t index = 0; index < entries.size(); ++index) {
+        const std::uint64_t key_hash = hash(entries[index].file_name, entries[index].file_type);
+        size_t i = key_hash & mask;
+        while (slots[i].entry != kEmpty) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = {key_hash, index};
+    }
+}
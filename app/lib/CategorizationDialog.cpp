@@ -283,24 +283,41 @@ void CategorizationDialog::on_confirm_and_sort_button_clicked()
 {
     ui_logger->info("Confirm and Sort clicked.");
 
+    // The categorizations must be on disk before any file is moved.
     record_categorization_to_db();
+    if (!db_manager->flush_writes()) {
+        ui_logger->error("Not all categorizations could be stored before sorting");
+    }
 
     auto files = get_categorized_files_from_treeview();
     std::vector<std::string> files_not_moved;
 
     if (!categorized_files.empty()) {
-        std::string dir_path = std::filesystem::path(categorized_files[0].file_path).string();
-
         GtkTreeIter iter;
         gboolean valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(liststore), &iter);
+        size_t index = 0;
 
         ui_logger->info("Files in treeview: {}, categorized_files: {}", files.size(), categorized_files.size());
         for (const auto& [file_name, file_type, category, subcategory] : files) {
             ui_logger->info("Processing: file={}, type={}, category={}, subcategory={}",
                 file_name, file_type, category, subcategory);
-            
+
+            if (index >= categorized_files.size()) {
+                ui_logger->warn("Mismatch between treeview files and categorized_files at index {}", index);
+                break;
+            }
+
+            // Recursive scans yield files from several directories; each one is
+            // sorted within the directory it was found in.
+            std::string dir_path = std::filesystem::path(categorized_files[index++].file_path).string();
             MovableCategorizedFile categorizedFile(dir_path, category, subcategory, file_name, file_type);
 
+            // Recorded before it exists, so a folder watch never sees the
+            // new folder unmarked.
+            const auto created_dir = categorizedFile.missing_cat_dir(show_subcategory_col);
+            if (!created_dir.empty()) {
+                db_manager->add_sort_destination(created_dir.string());
+            }
             categorizedFile.create_cat_dirs(show_subcategory_col);
             if (categorizedFile.move_file(show_subcategory_col)) {
                 const gchar *sorted_icon = "emblem-default";
@@ -378,35 +395,39 @@ void CategorizationDialog::on_subcategory_cell_edited(
 
 void CategorizationDialog::record_categorization_to_db() {
     auto files = get_categorized_files_from_treeview();
-    size_t index = 0;
-
-    for (const auto& [file_name, file_type, category, subcategory] : files) {
-        if (index < categorized_files.size()) {
-            std::string full_file_path = categorized_files[index].file_path;
-            std::string dir_path = std::filesystem::path(full_file_path).string();
-
-            DatabaseManager::ResolvedCategory resolved =
-                db_manager->resolve_category(category, subcategory);
-
-            db_manager->insert_or_update_file_with_categorization(
-                file_name, file_type, dir_path, resolved);
-
-            categorized_files[index].category = resolved.category;
-            categorized_files[index].subcategory = resolved.subcategory;
-            categorized_files[index].taxonomy_id = resolved.taxonomy_id;
-
-            GtkTreeIter iter;
-            if (gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(liststore), &iter, nullptr,
-                                              static_cast<int>(index))) {
-                gtk_list_store_set(liststore, &iter,
-                                   3, resolved.category.c_str(),
-                                   4, resolved.subcategory.c_str(),
-                                   -1);
-            }
-            index++;
-        } else {
-            ui_logger->warn("Mismatch between treeview files and categorized_files at index {}", index);
-            break;
-        }
+    if (files.size() > categorized_files.size()) {
+        ui_logger->warn("Mismatch between treeview files and categorized_files at index {}",
+                        categorized_files.size());
+        files.resize(categorized_files.size());
+    }
+
+    // Resolve every row first, then store them all in one transaction.
+    std::vector<DatabaseManager::CategorizationRecord> records;
+    records.reserve(files.size());
+    for (size_t index = 0; index < files.size(); ++index) {
+        const auto& [file_name, file_type, category, subcategory] = files[index];
+        std::string dir_path = std::filesystem::path(categorized_files[index].file_path).string();
+
+        DatabaseManager::ResolvedCategory resolved =
+            db_manager->resolve_category(category, subcategory);
+
+        categorized_files[index].category = resolved.category;
+        categorized_files[index].subcategory = resolved.subcategory;
+        categorized_files[index].taxonomy_id = resolved.taxonomy_id;
+        records.push_back({file_name, file_type, std::move(dir_path), std::move(resolved)});
+    }
+
+    if (!db_manager->insert_or_update_files_with_categorization(records)) {
+        ui_logger->error("Failed to queue {} categorization(s) for the database", records.size());
+    }
+
+    GtkTreeIter iter;
+    bool valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(liststore), &iter);
+    for (size_t index = 0; valid && index < records.size(); ++index) {
+        gtk_list_store_set(liststore, &iter,
+                           3, records[index].resolved.category.c_str(),
+                           4, records[index].resolved.subcategory.c_str(),
+                           -1);
+        valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(liststore), &iter);
     }
 }
@@ -0,0 +1,275 @@
+#include "CategorizationRules.hpp"
+#include "IniConfig.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+
+namespace {
+
+struct BuiltinRule {
+    std::string_view extension;
+    std::string_view category;
+    std::string_view subcategory;
+};
+
+// Only formats whose category does not depend on the file name. Installers
+// that need a description of the software (.exe, .dmg, .pkg) and code or
+// plain text are left to the LLM.
+constexpr BuiltinRule kBuiltinRules[] = {
+    {"jpg", "Images", "Photos"},
+    {"jpeg", "Images", "Photos"},
+    {"heic", "Images", "Photos"},
+    {"heif", "Images", "Photos"},
+    {"png", "Images", "Graphics"},
+    {"gif", "Images", "Animations"},
+    {"webp", "Images", "Web images"},
+    {"bmp", "Images", "Bitmaps"},
+    {"tif", "Images", "Bitmaps"},
+    {"tiff", "Images", "Bitmaps"},
+    {"svg", "Images", "Vector graphics"},
+    {"psd", "Images", "Photoshop projects"},
+    {"cr2", "Images", "Raw photos"},
+    {"cr3", "Images", "Raw photos"},
+    {"nef", "Images", "Raw photos"},
+    {"arw", "Images", "Raw photos"},
+    {"dng", "Images", "Raw photos"},
+    {"ico", "Images", "Icons"},
+    {"mp3", "Audio", "Music tracks"},
+    {"m4a", "Audio", "Music tracks"},
+    {"aac", "Audio", "Music tracks"},
+    {"ogg", "Audio", "Music tracks"},
+    {"opus", "Audio", "Music tracks"},
+    {"wma", "Audio", "Music tracks"},
+    {"flac", "Audio", "Lossless audio"},
+    {"wav", "Audio", "Lossless audio"},
+    {"aiff", "Audio", "Lossless audio"},
+    {"mp4", "Videos", "Movies and clips"},
+    {"m4v", "Videos", "Movies and clips"},
+    {"mov", "Videos", "Movies and clips"},
+    {"avi", "Videos", "Movies and clips"},
+    {"mkv", "Videos", "Movies and clips"},
+    {"webm", "Videos", "Movies and clips"},
+    {"wmv", "Videos", "Movies and clips"},
+    {"flv", "Videos", "Movies and clips"},
+    {"srt", "Videos", "Subtitles"},
+    {"vtt", "Videos", "Subtitles"},
+    {"pdf", "Documents", "PDF documents"},
+    {"doc", "Documents", "Word processing"},
+    {"docx", "Documents", "Word processing"},
+    {"odt", "Documents", "Word processing"},
+    {"rtf", "Documents", "Word processing"},
+    {"xls", "Spreadsheets", "Workbooks"},
+    {"xlsx", "Spreadsheets", "Workbooks"},
+    {"ods", "Spreadsheets", "Workbooks"},
+    {"csv", "Data", "CSV tables"},
+    {"ppt", "Presentations", "Slide decks"},
+    {"pptx", "Presentations", "Slide decks"},
+    {"odp", "Presentations", "Slide decks"},
+    {"epub", "Books", "E-books"},
+    {"mobi", "Books", "E-books"},
+    {"azw3", "Books", "E-books"},
+    {"iso", "Disk images", "Optical disc images"},
+    {"deb", "Installers", "Debian packages"},
+    {"rpm", "Installers", "RPM packages"},
+    {"apk", "Installers", "Android packages"},
+    {"zip", "Archives", "Compressed files"},
+    {"rar", "Archives", "Compressed files"},
+    {"7z", "Archives", "Compressed files"},
+    {"tar", "Archives", "Compressed files"},
+    {"gz", "Archives", "Compressed files"},
+    {"tgz", "Archives", "Compressed files"},
+    {"bz2", "Archives", "Compressed files"},
+    {"xz", "Archives", "Compressed files"},
+    {"zst", "Archives", "Compressed files"},
+    {"ttf", "Fonts", "Typefaces"},
+    {"otf", "Fonts", "Typefaces"},
+    {"woff", "Fonts", "Web fonts"},
+    {"woff2", "Fonts", "Web fonts"},
+    {"torrent", "Downloads", "Torrent files"},
+    {"ics", "Calendars", "Events"},
+    {"vcf", "Contacts", "Address cards"},
+};
+
+constexpr size_t kRuleCount = std::size(kBuiltinRules);
+constexpr size_t kSlotBits = 11;
+constexpr size_t kSlotCount = size_t{1} << kSlotBits;
+constexpr uint8_t kEmptySlot = 0xFF;
+constexpr size_t kMaxExtensionLength = 16;
+static_assert(kRuleCount < kEmptySlot, "slot indices are stored in a uint8_t");
+
+constexpr uint32_t hash_extension(std::string_view extension, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : extension) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    hash ^= hash >> 15;
+    return hash;
+}
+
+constexpr bool is_collision_free(uint32_t seed) {
+    std::array<bool, kSlotCount> used{};
+    for (const auto &rule : kBuiltinRules) {
+        size_t slot = hash_extension(rule.extension, seed) & (kSlotCount - 1);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t find_seed() {
+    for (uint32_t seed = 1; seed < 4096; ++seed) {
+        if (is_collision_free(seed)) return seed;
+    }
+    return 0;
+}
+
+constexpr uint32_t kSeed = find_seed();
+static_assert(kSeed != 0, "no collision-free seed for the built-in rules; raise kSlotBits");
+
+constexpr std::array<uint8_t, kSlotCount> kSlots = [] {
+    std::array<uint8_t, kSlotCount> slots{};
+    for (auto &slot : slots) slot = kEmptySlot;
+    for (size_t i = 0; i < kRuleCount; ++i) {
+        slots[hash_extension(kBuiltinRules[i].extension, kSeed) & (kSlotCount - 1)] =
+            static_cast<uint8_t>(i);
+    }
+    return slots;
+}();
+
+std::string to_lower(std::string_view text) {
+    std::string lowered(text);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lowered;
+}
+
+std::string trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) return "";
+    size_t end = text.find_last_not_of(" \t");
+    return std::string(text.substr(begin, end - begin + 1));
+}
+
+} // namespace
+
+
+CategorizationRules::CategorizationRules(const std::string &config_dir)
+{
+    auto rules_file = std::filesystem::path(config_dir) / "categorization_rules.ini";
+    std::error_code ec;
+    if (std::filesystem::exists(rules_file, ec)) {
+        load_user_rules(rules_file.string());
+    }
+}
+
+
+void CategorizationRules::load_user_rules(const std::string &rules_file)
+{
+    auto logger = Logger::get_logger("core_logger");
+    IniConfig config;
+    if (!config.load(rules_file)) {
+        return;
+    }
+
+    const auto *extensions = config.getSection("Extensions");
+    if (!extensions) {
+        return;
+    }
+
+    for (const auto &[key, value] : *extensions) {
+        std::string extension = to_lower(trim(key));
+        if (!extension.empty() && extension.front() == '.') {
+            extension.erase(0, 1);
+        }
+        if (extension.empty()) continue;
+
+        // match() only looks at the text after the last dot, up to kMaxExtensionLength.
+        if (extension.find('.') != std::string::npos || extension.size() > kMaxExtensionLength) {
+            if (logger) {
+                logger->warn("Ignoring rule for '.{}' in {}: expected a single extension of at most {} characters",
+                             extension, rules_file, kMaxExtensionLength);
+            }
+            continue;
+        }
+
+        // IniConfig only skips whole-line comments; drop a trailing one here.
+        std::string_view raw_rule = value;
+        if (size_t comment = raw_rule.find(';'); comment != std::string_view::npos) {
+            raw_rule = raw_rule.substr(0, comment);
+        }
+        std::string rule = trim(raw_rule);
+        if (rule == "-") {
+            user_rules[extension] = {"", ""};
+            continue;
+        }
+
+        size_t delimiter = rule.find(':');
+        std::string category = trim(std::string_view(rule).substr(0, delimiter));
+        std::string subcategory = delimiter == std::string::npos
+            ? "" : trim(std::string_view(rule).substr(delimiter + 1));
+        if (category.empty() || subcategory.empty()) {
+            if (logger) {
+                logger->warn("Ignoring rule for '.{}' in {}: expected '<Category> : <Subcategory>'",
+                             extension, rules_file);
+            }
+            continue;
+        }
+        user_rules[extension] = {std::move(category), std::move(subcategory)};
+    }
+
+    if (logger) {
+        logger->info("Loaded {} categorization rule(s) from {}", user_rules.size(), rules_file);
+    }
+}
+
+
+std::optional<CategorizationRules::Rule>
+CategorizationRules::match(std::string_view file_name, FileType file_type) const
+{
+    if (file_type != FileType::File) {
+        return std::nullopt;
+    }
+
+    // Same rule as fs::path::extension(): a leading dot does not start an extension.
+    size_t dot = file_name.find_last_of('.');
+    if (dot == std::string_view::npos || dot == 0 || dot + 1 == file_name.size()) {
+        return std::nullopt;
+    }
+    std::string_view extension = file_name.substr(dot + 1);
+    if (extension.size() > kMaxExtensionLength) {
+        return std::nullopt;
+    }
+
+    char lowered[kMaxExtensionLength];
+    for (size_t i = 0; i < extension.size(); ++i) {
+        lowered[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(extension[i])));
+    }
+    std::string_view key(lowered, extension.size());
+
+    if (!user_rules.empty()) {
+        auto it = user_rules.find(std::string(key));
+        if (it != user_rules.end()) {
+            if (it->second.first.empty()) {
+                return std::nullopt;
+            }
+            return Rule{it->second.first, it->second.second};
+        }
+    }
+
+    return match_builtin(key);
+}
+
+
+std::optional<CategorizationRules::Rule>
+CategorizationRules::match_builtin(std::string_view extension)
+{
+    uint8_t index = kSlots[hash_extension(extension, kSeed) & (kSlotCount - 1)];
+    if (index == kEmptySlot || kBuiltinRules[index].extension != extension) {
+        return std::nullopt;
+    }
+    return Rule{kBuiltinRules[index].category, kBuiltinRules[index].subcategory};
+}
@@ -0,0 +1,189 @@
+#include "ContentSniffer.hpp"
+
+#include <array>
+#include <cerrno>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_view_literals;
+
+namespace {
+
+using Refiner = const char* (*)(std::string_view header);
+
+struct MagicRule {
+    size_t offset;
+    std::string_view magic;
+    const char *description;
+    Refiner refine;  // optional, narrows down container formats
+};
+
+bool contains(std::string_view header, std::string_view needle) {
+    return header.find(needle) != std::string_view::npos;
+}
+
+bool matches_at(std::string_view header, size_t offset, std::string_view magic) {
+    return header.size() >= offset + magic.size() && header.substr(offset, magic.size()) == magic;
+}
+
+// ZIP local file headers store member names in clear text, and the first
+// members of the common container formats fit in the header window.
+const char* refine_zip(std::string_view header) {
+    if (contains(header, "mimetypeapplication/epub+zip"sv)) return "EPUB e-book";
+    if (contains(header, "mimetypeapplication/vnd.oasis.opendocument.text"sv)) return "OpenDocument text";
+    if (contains(header, "mimetypeapplication/vnd.oasis.opendocument.spreadsheet"sv)) return "OpenDocument spreadsheet";
+    if (contains(header, "mimetypeapplication/vnd.oasis.opendocument.presentation"sv)) return "OpenDocument presentation";
+    if (contains(header, "word/"sv)) return "Word document (DOCX)";
+    if (contains(header, "xl/"sv)) return "Excel spreadsheet (XLSX)";
+    if (contains(header, "ppt/"sv)) return "PowerPoint presentation (PPTX)";
+    if (contains(header, "[Content_Types].xml"sv)) return "Office Open XML document";
+    if (contains(header, "AndroidManifest.xml"sv)) return "Android app package (APK)";
+    if (contains(header, "META-INF/MANIFEST.MF"sv)) return "Java archive (JAR)";
+    return nullptr;
+}
+
+const char* refine_riff(std::string_view header) {
+    if (matches_at(header, 8, "WAVE"sv)) return "WAV audio";
+    if (matches_at(header, 8, "AVI "sv)) return "AVI video";
+    if (matches_at(header, 8, "WEBP"sv)) return "WebP image";
+    return nullptr;
+}
+
+const char* refine_iso_media(std::string_view header) {
+    if (header.size() < 12) return nullptr;
+    std::string_view brand = header.substr(8, 4);
+    if (brand == "qt  "sv) return "QuickTime video";
+    if (brand == "M4A "sv || brand == "M4B "sv) return "MPEG-4 audio (M4A)";
+    if (brand == "heic"sv || brand == "heix"sv || brand == "mif1"sv) return "HEIC image";
+    if (brand == "avif"sv) return "AVIF image";
+    if (brand.substr(0, 3) == "3gp"sv) return "3GP video";
+    return nullptr;
+}
+
+// First match wins, so more specific signatures come first.
+constexpr std::array<MagicRule, 42> kMagicRules = {{
+    {0, "%PDF-"sv, "PDF document", nullptr},
+    {0, "PK\x03\x04"sv, "ZIP archive", refine_zip},
+    {0, "PK\x05\x06"sv, "ZIP archive (empty)", nullptr},
+    {0, "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1"sv, "Legacy Microsoft Office document", nullptr},
+    {0, "{\\rtf"sv, "RTF document", nullptr},
+    {0, "%!PS"sv, "PostScript document", nullptr},
+    {0, "\x89PNG\r\n\x1A\n"sv, "PNG image", nullptr},
+    {0, "\xFF\xD8\xFF"sv, "JPEG image", nullptr},
+    {0, "GIF87a"sv, "GIF image", nullptr},
+    {0, "GIF89a"sv, "GIF image", nullptr},
+    {0, "II*\x00"sv, "TIFF image", nullptr},
+    {0, "MM\x00*"sv, "TIFF image", nullptr},
+    {0, "8BPS"sv, "Photoshop image", nullptr},
+    {0, "RIFF"sv, "RIFF media", refine_riff},
+    {4, "ftyp"sv, "MP4 video", refine_iso_media},
+    {0, "\x1A\x45\xDF\xA3"sv, "Matroska/WebM video", nullptr},
+    {0, "ID3"sv, "MP3 audio", nullptr},
+    {0, "\xFF\xFB"sv, "MP3 audio", nullptr},
+    {0, "\xFF\xF3"sv, "MP3 audio", nullptr},
+    {0, "\xFF\xF2"sv, "MP3 audio", nullptr},
+    {0, "fLaC"sv, "FLAC audio", nullptr},
+    {0, "OggS"sv, "Ogg media", nullptr},
+    {0, "\x7F" "ELF"sv, "ELF executable", nullptr},
+    {0, "MZ"sv, "Windows executable", nullptr},
+    {0, "\xCF\xFA\xED\xFE"sv, "Mach-O executable", nullptr},
+    {0, "\xCA\xFE\xBA\xBE"sv, "Mach-O universal binary or Java class", nullptr},
+    {0, "Rar!\x1A\x07"sv, "RAR archive", nullptr},
+    {0, "7z\xBC\xAF\x27\x1C"sv, "7-Zip archive", nullptr},
+    {0, "\x1F\x8B"sv, "gzip archive", nullptr},
+    {0, "BZh"sv, "bzip2 archive", nullptr},
+    {0, "\xFD" "7zXZ\x00"sv, "xz archive", nullptr},
+    {0, "\x28\xB5\x2F\xFD"sv, "Zstandard archive", nullptr},
+    {257, "ustar"sv, "tar archive", nullptr},
+    {0, "SQLite format 3\x00"sv, "SQLite database", nullptr},
+    {0, "wOFF"sv, "Web font (WOFF)", nullptr},
+    {0, "wOF2"sv, "Web font (WOFF2)", nullptr},
+    {0, "<?xml"sv, "XML document", nullptr},
+    {0, "<!DOCTYPE html"sv, "HTML document", nullptr},
+    {0, "<!doctype html"sv, "HTML document", nullptr},
+    {0, "<html"sv, "HTML document", nullptr},
+    {0, "#!"sv, "Script", nullptr},
+    {0, "\xEF\xBB\xBF"sv, "Text (UTF-8 with BOM)", nullptr},
+}};
+
+// Text if there are no NUL bytes and hardly any control characters; bytes
+// >= 0x80 are accepted so UTF-8 and legacy 8-bit encodings count as text.
+bool looks_like_text(std::string_view header) {
+    if (header.empty()) return false;
+    size_t control = 0;
+    for (unsigned char c : header) {
+        if (c == 0) return false;
+        if (c < 0x20 && c != '\n' && c != '\r' && c != '\t' && c != '\f') {
+            ++control;
+        }
+    }
+    return control * 100 <= header.size();
+}
+
+size_t read_header(const std::string &path, char *buffer, size_t capacity) {
+#ifndef _WIN32
+    // O_NONBLOCK keeps FIFOs from blocking the open; they are rejected below.
+    int flags = O_RDONLY | O_CLOEXEC | O_NONBLOCK;
+#ifdef O_NOATIME
+    int fd = ::open(path.c_str(), flags | O_NOATIME);
+    if (fd < 0 && errno == EPERM) {
+        fd = ::open(path.c_str(), flags);
+    }
+#else
+    int fd = ::open(path.c_str(), flags);
+#endif
+    if (fd < 0) return 0;
+
+    struct stat st;
+    ssize_t bytes = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        bytes = ::pread(fd, buffer, capacity, 0);
+    }
+    ::close(fd);
+    return bytes > 0 ? static_cast<size_t>(bytes) : 0;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return 0;
+    file.read(buffer, static_cast<std::streamsize>(capacity));
+    return static_cast<size_t>(file.gcount());
+#endif
+}
+
+} // namespace
+
+
+const char* ContentSniffer::sniff(const std::string &path)
+{
+    std::array<char, kMaxHeaderBytes> buffer;
+    size_t length = read_header(path, buffer.data(), buffer.size());
+    if (length == 0) {
+        return nullptr;
+    }
+    return identify(std::string_view(buffer.data(), length));
+}
+
+
+const char* ContentSniffer::identify(std::string_view header)
+{
+    if (header.size() > kMaxHeaderBytes) {
+        header = header.substr(0, kMaxHeaderBytes);
+    }
+
+    for (const auto &rule : kMagicRules) {
+        if (matches_at(header, rule.offset, rule.magic)) {
+            if (rule.refine) {
+                if (const char *refined = rule.refine(header)) {
+                    return refined;
+                }
+            }
+            return rule.description;
+        }
+    }
+
+    return looks_like_text(header) ? "Plain text" : nullptr;
+}
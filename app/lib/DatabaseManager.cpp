@@ -1,11 +1,15 @@
 #include "DatabaseManager.hpp"
+#include "EditDistance.hpp"
 #include "Types.hpp"
 #include "Logger.hpp"
+#include "ScanSnapshot.hpp"
 
 #include <algorithm>
 #include <cctype>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <filesystem>
 #include <iostream>
 #include <sstream>
 #include <utility>
@@ -18,6 +22,9 @@
 
 namespace {
 constexpr double kSimilarityThreshold = 0.85;
+constexpr double kScoreMargin = 1e-9;
+static_assert(kSimilarityThreshold > TaxonomyIndex::kMinThreshold,
+              "the trigram index would miss fuzzy matches below its minimum threshold");
 
 template <typename... Args>
 void db_log(spdlog::level::level_enum level, const char* fmt, Args&&... args) {
@@ -29,15 +36,40 @@ void db_log(spdlog::level::level_enum level, const char* fmt, Args&&... args) {
     }
 }
 
-bool is_duplicate_column_error(const char *error_msg) {
-    if (!error_msg) {
+bool exec_sql(sqlite3 *db, const char *sql, const char *action) {
+    char *error_msg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
+        db_log(spdlog::level::err, "Failed to {}: {}", action, error_msg ? error_msg : sqlite3_errmsg(db));
+        sqlite3_free(error_msg);
         return false;
     }
-    std::string message(error_msg);
-    std::transform(message.begin(), message.end(), message.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
-    return message.find("duplicate column name") != std::string::npos;
+    return true;
+}
+
+bool has_column(sqlite3 *db, const char *table, const char *column) {
+    sqlite3_stmt *stmt = nullptr;
+    bool found = false;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM pragma_table_info(?) WHERE name = ?;", -1, &stmt,
+                           nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+        found = sqlite3_step(stmt) == SQLITE_ROW;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// Paths strictly below `directory` are those in [first, last): with BINARY
+// collation they start with directory + separator, and last is that prefix
+// with the separator bumped to the next byte.
+std::pair<std::string, std::string> subtree_range(const std::string &directory) {
+    std::string first = directory;
+    if (first.empty() || first.back() != std::filesystem::path::preferred_separator) {
+        first.push_back(static_cast<char>(std::filesystem::path::preferred_separator));
+    }
+    std::string last = first;
+    last.back() = static_cast<char>(last.back() + 1);
+    return {first, last};
 }
 } // namespace
 
@@ -60,22 +92,179 @@ DatabaseManager::DatabaseManager(std::string config_dir)
     }
 
     sqlite3_extended_result_codes(db, 1);
+    configure_connection();
 
-    initialize_schema();
-    initialize_taxonomy_schema();
+    migrate_schema();
+#ifndef NDEBUG
+    check_query_plans();
+#endif
     load_taxonomy_cache();
+    load_sort_destinations();
+
+    readers = std::make_unique<ReadConnectionPool>(db_file, static_cast<size_t>(Statement::Count));
+    writer = std::make_unique<DatabaseWriter>(db_file, [this](const std::vector<int> &ids) {
+        drop_taxonomy_entries(ids);
+    });
+    if (!writer->is_open()) {
+        writer.reset();
+    }
 }
 
 DatabaseManager::~DatabaseManager() {
+    writer.reset();
+    readers.reset();
     if (db) {
         sqlite3_close(db);
         db = nullptr;
     }
 }
 
-void DatabaseManager::initialize_schema() {
+DatabaseManager::CachedStatement::~CachedStatement() {
+    if (stmt) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+}
+
+const char *DatabaseManager::statement_sql(Statement id) {
+    switch (id) {
+    // A directory's rows are stored together under its dir_id, so each
+    // directory matched below is read with one range scan.
+    case Statement::SelectDirectoryFiles:
+        return "SELECT d.path, f.file_name, f.file_type, f.category, f.subcategory, f.taxonomy_id "
+               "FROM directories d JOIN file_categorization f ON f.dir_id = d.id "
+               "WHERE d.path = ?;";
+    // Subtrees are selected as a range of paths (see subtree_range), which
+    // unlike substr() or LIKE can be answered from the path index.
+    case Statement::SelectSubtreeFiles:
+        return "SELECT d.path, f.file_name, f.file_type, f.category, f.subcategory, f.taxonomy_id "
+               "FROM directories d JOIN file_categorization f ON f.dir_id = d.id "
+               "WHERE d.path = ?1 OR (d.path >= ?2 AND d.path < ?3);";
+    case Statement::SelectSnapshotDirectories:
+        return "SELECT dir_path, inode, mtime_ns, scanned_at_ns FROM scan_directory "
+               "WHERE dir_path = ?1 OR (dir_path >= ?2 AND dir_path < ?3);";
+    case Statement::SelectSnapshotEntries:
+        return "SELECT dir_path, name, kind, is_symlink, is_hidden FROM scan_entry "
+               "WHERE dir_path = ?1 OR (dir_path >= ?2 AND dir_path < ?3) "
+               "ORDER BY dir_path;";
+    case Statement::SelectDirContents:
+        return "SELECT f.file_name FROM directories d "
+               "JOIN file_categorization f ON f.dir_id = d.id WHERE d.path = ?;";
+    case Statement::FileExists:
+        return "SELECT 1 FROM directories d JOIN file_categorization f ON f.dir_id = d.id "
+               "WHERE d.path = ?2 AND f.file_name = ?1 LIMIT 1;";
+    case Statement::Count:
+        break;
+    }
+    return nullptr;
+}
+
+DatabaseManager::CachedStatement DatabaseManager::statement(ReadConnectionPool::Lease &lease,
+                                                           Statement id) {
+    return CachedStatement(lease.statement(static_cast<size_t>(id), statement_sql(id)));
+}
+
+DatabaseManager::Transaction::Transaction(sqlite3 *db) : db(db) {
+    if (db && sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+        open = true;
+    } else if (db) {
+        db_log(spdlog::level::err, "Failed to begin transaction: {}", sqlite3_errmsg(db));
+    }
+}
+
+DatabaseManager::Transaction::~Transaction() {
+    if (open) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    }
+}
+
+bool DatabaseManager::Transaction::commit() {
+    if (!open) {
+        return false;
+    }
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        db_log(spdlog::level::err, "Failed to commit transaction: {}", sqlite3_errmsg(db));
+        return false;
+    }
+    open = false;
+    return true;
+}
+
+void DatabaseManager::configure_connection() {
+    // WAL lets readers proceed during writes, and with synchronous=NORMAL a
+    // commit only syncs at checkpoints; a crash may lose the last commits
+    // but never corrupts the database.
+    char *error_msg = nullptr;
+    if (sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &error_msg) != SQLITE_OK) {
+        db_log(spdlog::level::warn, "Failed to enable WAL journaling: {}", error_msg ? error_msg : "");
+        sqlite3_free(error_msg);
+        error_msg = nullptr;
+    }
+    if (sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, &error_msg) != SQLITE_OK) {
+        db_log(spdlog::level::warn, "Failed to set synchronous mode: {}", error_msg ? error_msg : "");
+        sqlite3_free(error_msg);
+    }
+    sqlite3_busy_timeout(db, 5000);
+}
+
+void DatabaseManager::migrate_schema() {
     if (!db) return;
 
+    // Databases created before the schema was versioned report version 0
+    // whatever they contain, so every step must also work on a database that
+    // already has some of its tables.
+    struct Migration {
+        int version;
+        const char *description;
+        bool (DatabaseManager::*apply)();
+    };
+    static constexpr Migration migrations[] = {
+        {1, "file categorization table", &DatabaseManager::initialize_schema},
+        {2, "category taxonomy and aliases", &DatabaseManager::initialize_taxonomy_schema},
+        {3, "taxonomy frequency triggers", &DatabaseManager::initialize_frequency_triggers},
+        {4, "scan snapshot tables", &DatabaseManager::initialize_scan_snapshot_schema},
+        {5, "lookup indexes", &DatabaseManager::initialize_lookup_indexes},
+        {6, "directory table", &DatabaseManager::initialize_directory_schema},
+        {7, "scan entries without per-entry metadata", &DatabaseManager::drop_scan_entry_metadata},
+        {8, "sort destinations", &DatabaseManager::initialize_sort_destination_schema},
+    };
+    constexpr int latest_version = migrations[std::size(migrations) - 1].version;
+
+    int version = 0;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    if (version > latest_version) {
+        db_log(spdlog::level::warn,
+               "Database schema version {} is newer than this build supports ({})",
+               version, latest_version);
+        return;
+    }
+
+    for (const auto &migration : migrations) {
+        if (migration.version <= version) {
+            continue;
+        }
+        Transaction transaction(db);
+        const std::string set_version = fmt::format("PRAGMA user_version = {};", migration.version);
+        if (!transaction.is_open() || !(this->*migration.apply)() ||
+            !exec_sql(db, set_version.c_str(), "record the schema version") ||
+            !transaction.commit()) {
+            db_log(spdlog::level::err, "Failed to migrate the database schema to version {} ({})",
+                   migration.version, migration.description);
+            return;
+        }
+        db_log(spdlog::level::info, "Migrated database schema to version {}: {}",
+               migration.version, migration.description);
+        version = migration.version;
+    }
+}
+
+bool DatabaseManager::initialize_schema() {
     const char *create_table_sql = R"(
         CREATE TABLE IF NOT EXISTS file_categorization (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -89,34 +278,24 @@ void DatabaseManager::initialize_schema() {
             UNIQUE(file_name, file_type, dir_path)
         );
     )";
-
-    char *error_msg = nullptr;
-    if (sqlite3_exec(db, create_table_sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to create file_categorization table: {}", error_msg);
-        sqlite3_free(error_msg);
+    if (!exec_sql(db, create_table_sql, "create file_categorization table")) {
+        return false;
     }
 
-    const char *add_column_sql = "ALTER TABLE file_categorization ADD COLUMN taxonomy_id INTEGER;";
-    if (sqlite3_exec(db, add_column_sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
-        if (!is_duplicate_column_error(error_msg)) {
-            db_log(spdlog::level::warn, "Failed to add taxonomy_id column: {}", error_msg ? error_msg : "");
-        }
-        if (error_msg) {
-            sqlite3_free(error_msg);
-        }
+    // Tables from before the taxonomy lack the column.
+    if (!has_column(db, "file_categorization", "taxonomy_id") &&
+        !exec_sql(db, "ALTER TABLE file_categorization ADD COLUMN taxonomy_id INTEGER;",
+                  "add taxonomy_id column")) {
+        return false;
     }
 
-    const char *create_index_sql =
-        "CREATE INDEX IF NOT EXISTS idx_file_categorization_taxonomy ON file_categorization(taxonomy_id);";
-    if (sqlite3_exec(db, create_index_sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to create taxonomy index: {}", error_msg);
-        sqlite3_free(error_msg);
-    }
+    return exec_sql(db,
+                    "CREATE INDEX IF NOT EXISTS idx_file_categorization_taxonomy "
+                    "ON file_categorization(taxonomy_id);",
+                    "create taxonomy index");
 }
 
-void DatabaseManager::initialize_taxonomy_schema() {
-    if (!db) return;
-
+bool DatabaseManager::initialize_taxonomy_schema() {
     const char *taxonomy_sql = R"(
         CREATE TABLE IF NOT EXISTS category_taxonomy (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -128,13 +307,6 @@ void DatabaseManager::initialize_taxonomy_schema() {
             UNIQUE(normalized_category, normalized_subcategory)
         );
     )";
-
-    char *error_msg = nullptr;
-    if (sqlite3_exec(db, taxonomy_sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to create category_taxonomy table: {}", error_msg);
-        sqlite3_free(error_msg);
-    }
-
     const char *alias_sql = R"(
         CREATE TABLE IF NOT EXISTS category_alias (
             alias_category_norm TEXT NOT NULL,
@@ -144,27 +316,222 @@ void DatabaseManager::initialize_taxonomy_schema() {
             FOREIGN KEY(taxonomy_id) REFERENCES category_taxonomy(id)
         );
     )";
-    if (sqlite3_exec(db, alias_sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to create category_alias table: {}", error_msg);
-        sqlite3_free(error_msg);
-    }
-
     const char *alias_index_sql =
         "CREATE INDEX IF NOT EXISTS idx_category_alias_taxonomy ON category_alias(taxonomy_id);";
-    if (sqlite3_exec(db, alias_index_sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to create alias index: {}", error_msg);
-        sqlite3_free(error_msg);
+
+    return exec_sql(db, taxonomy_sql, "create category_taxonomy table") &&
+           exec_sql(db, alias_sql, "create category_alias table") &&
+           exec_sql(db, alias_index_sql, "create alias index");
+}
+
+bool DatabaseManager::initialize_frequency_triggers() {
+    // category_taxonomy.frequency counts the file_categorization rows that
+    // point at each taxonomy entry; every row change adjusts it by one.
+    const char *triggers_sql = R"(
+        CREATE TRIGGER IF NOT EXISTS trg_file_categorization_insert
+        AFTER INSERT ON file_categorization
+        WHEN NEW.taxonomy_id IS NOT NULL
+        BEGIN
+            UPDATE category_taxonomy SET frequency = frequency + 1 WHERE id = NEW.taxonomy_id;
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS trg_file_categorization_delete
+        AFTER DELETE ON file_categorization
+        WHEN OLD.taxonomy_id IS NOT NULL
+        BEGIN
+            UPDATE category_taxonomy SET frequency = frequency - 1 WHERE id = OLD.taxonomy_id;
+        END;
+
+        CREATE TRIGGER IF NOT EXISTS trg_file_categorization_update
+        AFTER UPDATE OF taxonomy_id ON file_categorization
+        WHEN OLD.taxonomy_id IS NOT NEW.taxonomy_id
+        BEGIN
+            UPDATE category_taxonomy SET frequency = frequency - 1 WHERE id = OLD.taxonomy_id;
+            UPDATE category_taxonomy SET frequency = frequency + 1 WHERE id = NEW.taxonomy_id;
+        END;
+    )";
+
+    // Counters written before the triggers existed may be stale.
+    return exec_sql(db, triggers_sql, "create taxonomy frequency triggers") &&
+           recompute_taxonomy_frequencies() >= 0;
+}
+
+bool DatabaseManager::initialize_scan_snapshot_schema() {
+    const char *directory_sql = R"(
+        CREATE TABLE IF NOT EXISTS scan_directory (
+            dir_path TEXT PRIMARY KEY,
+            inode INTEGER NOT NULL,
+            mtime_ns INTEGER NOT NULL,
+            scanned_at_ns INTEGER NOT NULL
+        );
+    )";
+    const char *entry_sql = R"(
+        CREATE TABLE IF NOT EXISTS scan_entry (
+            dir_path TEXT NOT NULL,
+            name TEXT NOT NULL,
+            kind INTEGER NOT NULL,
+            is_symlink INTEGER NOT NULL,
+            is_hidden INTEGER NOT NULL,
+            inode INTEGER NOT NULL,
+            size INTEGER NOT NULL,
+            mtime_ns INTEGER NOT NULL,
+            PRIMARY KEY(dir_path, name)
+        ) WITHOUT ROWID;
+    )";
+
+    return exec_sql(db, directory_sql, "create scan_directory table") &&
+           exec_sql(db, entry_sql, "create scan_entry table");
+}
+
+bool DatabaseManager::initialize_lookup_indexes() {
+    // Lookups by name go through the UNIQUE(file_name, file_type, dir_path)
+    // index. Listings by directory get a covering index, so they never touch
+    // the table itself.
+    const char *directory_index_sql = R"(
+        CREATE INDEX IF NOT EXISTS idx_file_categorization_dir
+        ON file_categorization(dir_path, file_name, file_type, category, subcategory, taxonomy_id);
+    )";
+    return exec_sql(db, directory_index_sql, "create directory index");
+}
+
+bool DatabaseManager::initialize_directory_schema() {
+    if (has_column(db, "file_categorization", "dir_id")) {
+        return true;
     }
+
+    // Every row named its directory by full path, and both indexes repeated
+    // it. Paths now live once in directories; file_categorization is rebuilt
+    // without a rowid, keyed by (dir_id, file_type, file_name), so the rows
+    // of a directory sit together in the table itself. Ids are assigned in
+    // path order so existing subtrees start out close together.
+    const char *directory_sql = R"(
+        CREATE TABLE IF NOT EXISTS directories (
+            id INTEGER PRIMARY KEY,
+            path TEXT NOT NULL UNIQUE
+        );
+        INSERT OR IGNORE INTO directories (path)
+            SELECT DISTINCT dir_path FROM file_categorization ORDER BY dir_path;
+    )";
+    const char *rebuild_sql = R"(
+        CREATE TABLE file_categorization_by_dir (
+            dir_id INTEGER NOT NULL REFERENCES directories(id),
+            file_type TEXT NOT NULL,
+            file_name TEXT NOT NULL,
+            category TEXT NOT NULL,
+            subcategory TEXT,
+            taxonomy_id INTEGER,
+            timestamp DATETIME DEFAULT CURRENT_TIMESTAMP,
+            PRIMARY KEY(dir_id, file_type, file_name)
+        ) WITHOUT ROWID;
+        INSERT INTO file_categorization_by_dir
+            (dir_id, file_type, file_name, category, subcategory, taxonomy_id, timestamp)
+            SELECT d.id, f.file_type, f.file_name, f.category, f.subcategory, f.taxonomy_id, f.timestamp
+            FROM file_categorization f JOIN directories d ON d.path = f.dir_path;
+        DROP TABLE file_categorization;
+        ALTER TABLE file_categorization_by_dir RENAME TO file_categorization;
+        CREATE INDEX idx_file_categorization_taxonomy ON file_categorization(taxonomy_id);
+    )";
+
+    // Dropping the old table took its frequency triggers with it.
+    return exec_sql(db, directory_sql, "create directories table") &&
+           exec_sql(db, rebuild_sql, "rebuild file_categorization by directory") &&
+           initialize_frequency_triggers();
 }
 
-void DatabaseManager::load_taxonomy_cache() {
-    taxonomy_entries.clear();
-    canonical_lookup.clear();
-    alias_lookup.clear();
-    taxonomy_index.clear();
+bool DatabaseManager::drop_scan_entry_metadata() {
+    if (!has_column(db, "scan_entry", "inode")) {
+        return true;
+    }
 
+    // Listings only need what the scanner replays; stat-ing every entry for
+    // an inode, size and mtime nobody read cost more than getdents saved.
+    // The stored listings are only a cache, so they are dropped rather than
+    // copied and are read again by the next scan.
+    const char *rebuild_sql = R"(
+        DELETE FROM scan_directory;
+        DROP TABLE scan_entry;
+        CREATE TABLE scan_entry (
+            dir_path TEXT NOT NULL,
+            name TEXT NOT NULL,
+            kind INTEGER NOT NULL,
+            is_symlink INTEGER NOT NULL,
+            is_hidden INTEGER NOT NULL,
+            PRIMARY KEY(dir_path, name)
+        ) WITHOUT ROWID;
+    )";
+    return exec_sql(db, rebuild_sql, "rebuild scan_entry without metadata");
+}
+
+bool DatabaseManager::initialize_sort_destination_schema() {
+    // Folders that Confirm and Sort created, by full path. Only these are
+    // skipped by later scans; a folder that merely shares a category's name
+    // is the user's own.
+    const char *sort_destination_sql = R"(
+        CREATE TABLE IF NOT EXISTS sort_destination (
+            path TEXT PRIMARY KEY
+        ) WITHOUT ROWID;
+    )";
+    return exec_sql(db, sort_destination_sql, "create sort_destination table");
+}
+
+#ifndef NDEBUG
+void DatabaseManager::check_query_plans() const {
     if (!db) return;
 
+    for (size_t i = 0; i < static_cast<size_t>(Statement::Count); ++i) {
+        std::string sql = statement_sql(static_cast<Statement>(i));
+        sql.erase(std::unique(sql.begin(), sql.end(), [](char a, char b) {
+                      return std::isspace(static_cast<unsigned char>(a)) &&
+                             std::isspace(static_cast<unsigned char>(b));
+                  }),
+                  sql.end());
+        std::replace(sql.begin(), sql.end(), '\n', ' ');
+        sql.erase(0, sql.find_first_not_of(' '));
+        sql.erase(sql.find_last_not_of(' ') + 1);
+
+        sqlite3_stmt *stmt = nullptr;
+        const std::string explain = "EXPLAIN QUERY PLAN " + sql;
+        if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            db_log(spdlog::level::err, "Failed to explain '{}': {}", sql, sqlite3_errmsg(db));
+            sqlite3_finalize(stmt);
+            continue;
+        }
+        db_log(spdlog::level::info, "Query plan for '{}':", sql);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *detail = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+            std::string_view step = detail ? detail : "";
+            // SEARCH uses an index to find rows; SCAN visits all of them.
+            bool full_scan = step.substr(0, 4) == "SCAN";
+            db_log(full_scan ? spdlog::level::warn : spdlog::level::info, "    {}{}", step,
+                   full_scan ? "  <-- full scan" : "");
+        }
+        sqlite3_finalize(stmt);
+    }
+}
+#endif
+
+void DatabaseManager::TaxonomySnapshot::add(TaxonomyEntry entry) {
+    index[entry.id] = entries.size();
+    fuzzy_index.add(entries.size(), entry.normalized_category, entry.normalized_subcategory);
+    canonical_lookup[make_key(entry.normalized_category, entry.normalized_subcategory)] = entry.id;
+    entries.push_back(std::move(entry));
+}
+
+const DatabaseManager::TaxonomyEntry *DatabaseManager::TaxonomySnapshot::find(int taxonomy_id) const {
+    auto it = index.find(taxonomy_id);
+    if (it == index.end() || it->second >= entries.size()) {
+        return nullptr;
+    }
+    return &entries[it->second];
+}
+
+void DatabaseManager::load_taxonomy_cache() {
+    auto snapshot = std::make_shared<TaxonomySnapshot>();
+    if (!db) {
+        std::atomic_store(&taxonomy, std::shared_ptr<const TaxonomySnapshot>(std::move(snapshot)));
+        return;
+    }
+
     sqlite3_stmt *stmt = nullptr;
     const char *select_taxonomy =
         "SELECT id, canonical_category, canonical_subcategory, "
@@ -178,10 +545,7 @@ void DatabaseManager::load_taxonomy_cache() {
             entry.subcategory = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
             entry.normalized_category = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
             entry.normalized_subcategory = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4));
-
-            taxonomy_index[entry.id] = taxonomy_entries.size();
-            taxonomy_entries.push_back(entry);
-            canonical_lookup[make_key(entry.normalized_category, entry.normalized_subcategory)] = entry.id;
+            snapshot->add(std::move(entry));
         }
     } else {
         db_log(spdlog::level::err, "Failed to load taxonomy cache: {}", sqlite3_errmsg(db));
@@ -196,12 +560,26 @@ void DatabaseManager::load_taxonomy_cache() {
             std::string alias_subcat = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
             int taxonomy_id = sqlite3_column_int(stmt, 2);
 
-            alias_lookup[make_key(alias_cat, alias_subcat)] = taxonomy_id;
+            snapshot->alias_lookup[make_key(alias_cat, alias_subcat)] = taxonomy_id;
         }
     } else {
         db_log(spdlog::level::err, "Failed to load category aliases: {}", sqlite3_errmsg(db));
     }
     if (stmt) sqlite3_finalize(stmt);
+
+    // AUTOINCREMENT never reuses an id, not even one whose row was deleted.
+    const char *select_next_id =
+        "SELECT MAX(COALESCE((SELECT MAX(id) FROM category_taxonomy), 0), "
+        "COALESCE((SELECT seq FROM sqlite_sequence WHERE name = 'category_taxonomy'), 0)) + 1;";
+    if (sqlite3_prepare_v2(db, select_next_id, -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        next_taxonomy_id = sqlite3_column_int(stmt, 0);
+    } else {
+        db_log(spdlog::level::err, "Failed to read the next taxonomy id: {}", sqlite3_errmsg(db));
+    }
+    if (stmt) sqlite3_finalize(stmt);
+
+    std::atomic_store(&taxonomy, std::shared_ptr<const TaxonomySnapshot>(std::move(snapshot)));
 }
 
 std::string DatabaseManager::normalize_label(const std::string &input) const {
@@ -231,36 +609,6 @@ std::string DatabaseManager::normalize_label(const std::string &input) const {
     return result;
 }
 
-double DatabaseManager::string_similarity(const std::string &a, const std::string &b) {
-    if (a == b) {
-        return 1.0;
-    }
-    if (a.empty() || b.empty()) {
-        return 0.0;
-    }
-
-    const size_t m = a.size();
-    const size_t n = b.size();
-    std::vector<size_t> prev(n + 1), curr(n + 1);
-
-    for (size_t j = 0; j <= n; ++j) {
-        prev[j] = j;
-    }
-
-    for (size_t i = 1; i <= m; ++i) {
-        curr[0] = i;
-        for (size_t j = 1; j <= n; ++j) {
-            size_t cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
-            curr[j] = std::min({prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + cost});
-        }
-        std::swap(prev, curr);
-    }
-
-    const double dist = static_cast<double>(prev[n]);
-    const double max_len = static_cast<double>(std::max(m, n));
-    return 1.0 - (dist / max_len);
-}
-
 std::string DatabaseManager::make_key(const std::string &norm_category,
                                       const std::string &norm_subcategory) {
     return norm_category + "::" + norm_subcategory;
@@ -270,141 +618,125 @@ int DatabaseManager::create_taxonomy_entry(const std::string &category,
                                            const std::string &subcategory,
                                            const std::string &norm_category,
                                            const std::string &norm_subcategory) {
-    if (!db) return -1;
-
-    const char *sql = R"(
-        INSERT INTO category_taxonomy
-            (canonical_category, canonical_subcategory, normalized_category, normalized_subcategory, frequency)
-        VALUES (?, ?, ?, ?, 0);
-    )";
-
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to prepare taxonomy insert: {}", sqlite3_errmsg(db));
-        return -1;
-    }
-
-    sqlite3_bind_text(stmt, 1, category.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, subcategory.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, norm_category.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, norm_subcategory.c_str(), -1, SQLITE_TRANSIENT);
-
-    int step_rc = sqlite3_step(stmt);
-    int extended_rc = sqlite3_extended_errcode(db);
-    sqlite3_finalize(stmt);
-
-    if (step_rc != SQLITE_DONE) {
-        if (extended_rc == SQLITE_CONSTRAINT_UNIQUE ||
-            extended_rc == SQLITE_CONSTRAINT_PRIMARYKEY ||
-            extended_rc == SQLITE_CONSTRAINT) {
-            return find_existing_taxonomy_id(norm_category, norm_subcategory);
-        }
+    if (!writer || next_taxonomy_id <= 0) return -1;
 
-        db_log(spdlog::level::err, "Failed to insert taxonomy entry: {}", sqlite3_errmsg(db));
+    // Ids are handed out here, under taxonomy_mutex, so the entry can be
+    // used before the writer has stored it.
+    const int new_id = next_taxonomy_id;
+    if (!writer->insert_taxonomy(new_id, category, subcategory, norm_category, norm_subcategory)) {
         return -1;
     }
-
-    int new_id = static_cast<int>(sqlite3_last_insert_rowid(db));
-    TaxonomyEntry entry{new_id, category, subcategory, norm_category, norm_subcategory};
-    taxonomy_index[new_id] = taxonomy_entries.size();
-    taxonomy_entries.push_back(entry);
-    canonical_lookup[make_key(norm_category, norm_subcategory)] = new_id;
+    ++next_taxonomy_id;
     return new_id;
 }
 
-int DatabaseManager::find_existing_taxonomy_id(const std::string &norm_category,
-                                               const std::string &norm_subcategory) const {
-    if (!db) return -1;
-
-    const char *select_sql =
-        "SELECT id FROM category_taxonomy WHERE normalized_category = ? AND normalized_subcategory = ? LIMIT 1;";
-    sqlite3_stmt *stmt = nullptr;
-    int existing_id = -1;
+void DatabaseManager::drop_taxonomy_entries(const std::vector<int> &ids) {
+    std::lock_guard<std::mutex> lock(taxonomy_mutex);
 
-    if (sqlite3_prepare_v2(db, select_sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, norm_category.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, norm_subcategory.c_str(), -1, SQLITE_TRANSIENT);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            existing_id = sqlite3_column_int(stmt, 0);
+    // Entries are only ever appended, so the snapshot is rebuilt without them.
+    const std::unordered_set<int> dropped(ids.begin(), ids.end());
+    std::shared_ptr<const TaxonomySnapshot> current = std::atomic_load(&taxonomy);
+    auto next = std::make_shared<TaxonomySnapshot>();
+    for (const auto &entry : current->entries) {
+        if (!dropped.contains(entry.id)) {
+            next->add(entry);
         }
     }
-
-    if (stmt) {
-        sqlite3_finalize(stmt);
+    for (const auto &[key, taxonomy_id] : current->alias_lookup) {
+        if (!dropped.contains(taxonomy_id)) {
+            next->alias_lookup.emplace(key, taxonomy_id);
+        }
     }
-    return existing_id;
+    std::atomic_store(&taxonomy, std::shared_ptr<const TaxonomySnapshot>(std::move(next)));
+    db_log(spdlog::level::warn, "Dropped {} taxonomy entr(ies) that could not be stored", ids.size());
 }
 
-void DatabaseManager::ensure_alias_mapping(int taxonomy_id,
-                                           const std::string &norm_category,
-                                           const std::string &norm_subcategory) {
-    if (!db) return;
-
-    std::string key = make_key(norm_category, norm_subcategory);
-
-    auto canonical_it = canonical_lookup.find(key);
-    if (canonical_it != canonical_lookup.end() && canonical_it->second == taxonomy_id) {
-        return; // Already canonical form
+bool DatabaseManager::needs_alias_mapping(const TaxonomySnapshot &taxonomy, int taxonomy_id,
+                                          const std::string &key) {
+    auto canonical_it = taxonomy.canonical_lookup.find(key);
+    if (canonical_it != taxonomy.canonical_lookup.end() && canonical_it->second == taxonomy_id) {
+        return false; // Already canonical form
     }
+    return taxonomy.alias_lookup.find(key) == taxonomy.alias_lookup.end();
+}
 
-    if (alias_lookup.find(key) != alias_lookup.end()) {
-        return;
+std::shared_ptr<const DatabaseManager::TaxonomySnapshot> DatabaseManager::extend_taxonomy(
+    int &taxonomy_id,
+    const std::string &category,
+    const std::string &subcategory,
+    const std::string &norm_category,
+    const std::string &norm_subcategory,
+    const std::string &key) {
+    std::lock_guard<std::mutex> lock(taxonomy_mutex);
+
+    // Another thread may have added the labels since the caller looked.
+    std::shared_ptr<const TaxonomySnapshot> current = std::atomic_load(&taxonomy);
+    if (taxonomy_id == -1) {
+        taxonomy_id = resolve_existing_taxonomy(*current, key, norm_category, norm_subcategory);
     }
 
-    const char *sql = R"(
-        INSERT OR IGNORE INTO category_alias (alias_category_norm, alias_subcategory_norm, taxonomy_id)
-        VALUES (?, ?, ?);
-    )";
-
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to prepare alias insert: {}", sqlite3_errmsg(db));
-        return;
+    std::shared_ptr<TaxonomySnapshot> next;
+    if (taxonomy_id == -1) {
+        taxonomy_id = create_taxonomy_entry(category, subcategory, norm_category, norm_subcategory);
+        if (taxonomy_id == -1) {
+            return current;
+        }
+        next = std::make_shared<TaxonomySnapshot>(*current);
+        if (!next->find(taxonomy_id)) {
+            next->add({taxonomy_id, category, subcategory, norm_category, norm_subcategory});
+        }
     }
 
-    sqlite3_bind_text(stmt, 1, norm_category.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, norm_subcategory.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 3, taxonomy_id);
-
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        db_log(spdlog::level::err, "Failed to insert alias: {}", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
-        return;
+    if (writer && needs_alias_mapping(next ? *next : *current, taxonomy_id, key) &&
+        writer->insert_alias(norm_category, norm_subcategory, taxonomy_id)) {
+        if (!next) {
+            next = std::make_shared<TaxonomySnapshot>(*current);
+        }
+        next->alias_lookup[key] = taxonomy_id;
     }
 
-    sqlite3_finalize(stmt);
-    alias_lookup[key] = taxonomy_id;
-}
-
-const DatabaseManager::TaxonomyEntry *DatabaseManager::find_taxonomy_entry(int taxonomy_id) const {
-    auto it = taxonomy_index.find(taxonomy_id);
-    if (it == taxonomy_index.end()) {
-        return nullptr;
-    }
-    size_t idx = it->second;
-    if (idx >= taxonomy_entries.size()) {
-        return nullptr;
+    if (!next) {
+        return current;
     }
-    return &taxonomy_entries[idx];
+    std::atomic_store(&taxonomy, std::shared_ptr<const TaxonomySnapshot>(next));
+    return next;
 }
 
 std::pair<int, double> DatabaseManager::find_fuzzy_match(
+    const TaxonomySnapshot& taxonomy,
     const std::string& norm_category,
-    const std::string& norm_subcategory) const {
-    if (taxonomy_entries.empty()) {
+    const std::string& norm_subcategory) {
+    if (taxonomy.entries.empty()) {
         return {-1, 0.0};
     }
 
+    // Only entries that can still reach the threshold are scored, best bound
+    // first; ties go to the earliest entry, as in a full scan.
     double best_score = 0.0;
     int best_id = -1;
-    for (const auto &entry : taxonomy_entries) {
-        double category_score = string_similarity(norm_category, entry.normalized_category);
-        double subcategory_score =
-            string_similarity(norm_subcategory, entry.normalized_subcategory);
+    size_t best_entry = taxonomy.entries.size();
+    for (const auto &candidate : taxonomy.fuzzy_index.candidates(norm_category, norm_subcategory,
+                                                                 kSimilarityThreshold)) {
+        if (candidate.upper_bound < best_score) {
+            break;
+        }
+        // Each label only needs enough similarity for the average to reach
+        // the threshold and the best score so far; the margin leaves exact
+        // ties to the comparison below.
+        const auto &entry = taxonomy.entries[candidate.entry];
+        const double target = std::max(kSimilarityThreshold, best_score);
+        double category_score = EditDistance::similarity(
+            norm_category, entry.normalized_category, 2.0 * target - 1.0 - kScoreMargin);
+        if (category_score == 0.0) {
+            continue;
+        }
+        double subcategory_score = EditDistance::similarity(
+            norm_subcategory, entry.normalized_subcategory, 2.0 * target - category_score - kScoreMargin);
         double combined = (category_score + subcategory_score) / 2.0;
-        if (combined > best_score) {
+        if (combined > best_score || (combined == best_score && candidate.entry < best_entry)) {
             best_score = combined;
             best_id = entry.id;
+            best_entry = candidate.entry;
         }
     }
 
@@ -414,49 +746,40 @@ std::pair<int, double> DatabaseManager::find_fuzzy_match(
     return {-1, best_score};
 }
 
-int DatabaseManager::resolve_existing_taxonomy(const std::string& key,
+int DatabaseManager::resolve_existing_taxonomy(const TaxonomySnapshot& taxonomy,
+                                               const std::string& key,
                                                const std::string& norm_category,
-                                               const std::string& norm_subcategory) const {
-    auto alias_it = alias_lookup.find(key);
-    if (alias_it != alias_lookup.end()) {
+                                               const std::string& norm_subcategory) {
+    auto alias_it = taxonomy.alias_lookup.find(key);
+    if (alias_it != taxonomy.alias_lookup.end()) {
         return alias_it->second;
     }
 
-    auto canonical_it = canonical_lookup.find(key);
-    if (canonical_it != canonical_lookup.end()) {
+    auto canonical_it = taxonomy.canonical_lookup.find(key);
+    if (canonical_it != taxonomy.canonical_lookup.end()) {
         return canonical_it->second;
     }
 
-    auto [best_id, score] = find_fuzzy_match(norm_category, norm_subcategory);
+    auto [best_id, score] = find_fuzzy_match(taxonomy, norm_category, norm_subcategory);
     return best_id;
 }
 
 DatabaseManager::ResolvedCategory DatabaseManager::build_resolved_category(
+    const TaxonomySnapshot& taxonomy,
     int taxonomy_id,
     const std::string& fallback_category,
-    const std::string& fallback_subcategory,
-    const std::string& norm_category,
-    const std::string& norm_subcategory) {
+    const std::string& fallback_subcategory) {
 
     ResolvedCategory result{-1, fallback_category, fallback_subcategory};
 
-    if (taxonomy_id == -1) {
-        taxonomy_id = create_taxonomy_entry(fallback_category, fallback_subcategory,
-                                            norm_category, norm_subcategory);
-    }
-
     if (taxonomy_id != -1) {
-        ensure_alias_mapping(taxonomy_id, norm_category, norm_subcategory);
-        if (const auto *entry = find_taxonomy_entry(taxonomy_id)) {
+        if (const auto *entry = taxonomy.find(taxonomy_id)) {
             result.taxonomy_id = entry->id;
             result.category = entry->category;
             result.subcategory = entry->subcategory;
         } else {
             result.taxonomy_id = taxonomy_id;
         }
-    } else {
-        result.category = fallback_category;
-        result.subcategory = fallback_subcategory;
     }
 
     return result;
@@ -494,12 +817,14 @@ DatabaseManager::resolve_category(const std::string &category,
     std::string norm_subcategory = normalize_label(trimmed_subcategory);
     std::string key = make_key(norm_category, norm_subcategory);
 
-    int taxonomy_id = resolve_existing_taxonomy(key, norm_category, norm_subcategory);
-    return build_resolved_category(taxonomy_id,
-                                   trimmed_category,
-                                   trimmed_subcategory,
-                                   norm_category,
-                                   norm_subcategory);
+    // Known labels resolve from the current snapshot without locking.
+    std::shared_ptr<const TaxonomySnapshot> snapshot = std::atomic_load(&taxonomy);
+    int taxonomy_id = resolve_existing_taxonomy(*snapshot, key, norm_category, norm_subcategory);
+    if (taxonomy_id == -1 || needs_alias_mapping(*snapshot, taxonomy_id, key)) {
+        snapshot = extend_taxonomy(taxonomy_id, trimmed_category, trimmed_subcategory,
+                                   norm_category, norm_subcategory, key);
+    }
+    return build_resolved_category(*snapshot, taxonomy_id, trimmed_category, trimmed_subcategory);
 }
 
 bool DatabaseManager::insert_or_update_file_with_categorization(
@@ -507,93 +832,84 @@ bool DatabaseManager::insert_or_update_file_with_categorization(
     const std::string &file_type,
     const std::string &dir_path,
     const ResolvedCategory &resolved) {
-    if (!db) return false;
-
-    const char *sql = R"(
-        INSERT INTO file_categorization
-            (file_name, file_type, dir_path, category, subcategory, taxonomy_id)
-        VALUES (?, ?, ?, ?, ?, ?)
-        ON CONFLICT(file_name, file_type, dir_path)
-        DO UPDATE SET
-            category = excluded.category,
-            subcategory = excluded.subcategory,
-            taxonomy_id = excluded.taxonomy_id;
-    )";
-
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        db_log(spdlog::level::err, "SQL prepare error: {}", sqlite3_errmsg(db));
-        return false;
-    }
-
-    sqlite3_bind_text(stmt, 1, file_name.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, file_type.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, dir_path.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, resolved.category.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 5, resolved.subcategory.c_str(), -1, SQLITE_TRANSIENT);
+    return insert_or_update_files_with_categorization(
+        {CategorizationRecord{file_name, file_type, dir_path, resolved}});
+}
 
-    if (resolved.taxonomy_id > 0) {
-        sqlite3_bind_int(stmt, 6, resolved.taxonomy_id);
-    } else {
-        sqlite3_bind_null(stmt, 6);
+bool DatabaseManager::insert_or_update_files_with_categorization(
+    const std::vector<CategorizationRecord> &records) {
+    if (!writer) return false;
+    if (records.empty()) return true;
+
+    std::vector<DatabaseWriter::FileRow> rows;
+    rows.reserve(records.size());
+    for (const auto &record : records) {
+        rows.push_back({record.file_name, record.file_type, record.dir_path,
+                        record.resolved.category, record.resolved.subcategory,
+                        record.resolved.taxonomy_id});
     }
-
-    bool success = true;
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        db_log(spdlog::level::err, "SQL error during insert/update: {}", sqlite3_errmsg(db));
-        success = false;
+    if (!writer->upsert_files(std::move(rows))) {
+        return false;
     }
 
-    sqlite3_finalize(stmt);
-
-    if (success && resolved.taxonomy_id > 0) {
-        increment_taxonomy_frequency(resolved.taxonomy_id);
+    // The cache reflects queued rows at once, so lookups see them before
+    // the writer commits them.
+    for (const auto &record : records) {
+        cache_categorization(record.file_name, record.file_type, record.dir_path, record.resolved);
     }
-
-    return success;
+    db_log(spdlog::level::debug, "Queued {} categorization(s) for writing", records.size());
+    return true;
 }
 
-void DatabaseManager::increment_taxonomy_frequency(int taxonomy_id) {
-    if (!db || taxonomy_id <= 0) return;
+bool DatabaseManager::flush_writes() {
+    return writer && writer->flush();
+}
 
-    const char *sql =
-        "UPDATE category_taxonomy "
-        "SET frequency = (SELECT COUNT(*) FROM file_categorization WHERE taxonomy_id = ?) "
-        "WHERE id = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to prepare frequency update: {}", sqlite3_errmsg(db));
-        return;
-    }
+int DatabaseManager::recompute_taxonomy_frequencies() {
+    if (!db) return -1;
 
-    sqlite3_bind_int(stmt, 1, taxonomy_id);
-    sqlite3_bind_int(stmt, 2, taxonomy_id);
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        db_log(spdlog::level::err, "Failed to increment taxonomy frequency: {}", sqlite3_errmsg(db));
+    const char *sql = R"(
+        UPDATE category_taxonomy
+        SET frequency = (SELECT COUNT(*) FROM file_categorization
+                         WHERE file_categorization.taxonomy_id = category_taxonomy.id);
+    )";
+    char *error_msg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
+        db_log(spdlog::level::err, "Failed to recompute taxonomy frequencies: {}",
+               error_msg ? error_msg : "");
+        sqlite3_free(error_msg);
+        return -1;
     }
-    sqlite3_finalize(stmt);
+    return sqlite3_changes(db);
 }
 
 std::vector<CategorizedFile>
-DatabaseManager::get_categorized_files(const std::string &directory_path) {
+DatabaseManager::get_categorized_files(const std::string &directory_path,
+                                       bool include_subdirectories) {
     std::vector<CategorizedFile> categorized_files;
-    if (!db) return categorized_files;
-
-    const char *sql =
-        "SELECT dir_path, file_name, file_type, category, subcategory, taxonomy_id "
-        "FROM file_categorization WHERE dir_path = ?;";
-    sqlite3_stmt *stmtcat = nullptr;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmtcat, nullptr) != SQLITE_OK) {
+    if (!readers) return categorized_files;
+
+    auto lease = readers->acquire();
+    if (!lease) return categorized_files;
+    auto cached = include_subdirectories
+        ? statement(lease, Statement::SelectSubtreeFiles)
+        : statement(lease, Statement::SelectDirectoryFiles);
+    sqlite3_stmt *stmtcat = cached.get();
+    if (!stmtcat) {
         return categorized_files;
     }
 
     if (sqlite3_bind_text(stmtcat, 1, directory_path.c_str(), -1, SQLITE_TRANSIENT) != SQLITE_OK) {
-        db_log(spdlog::level::err, "Failed to bind directory_path: {}", sqlite3_errmsg(db));
-        sqlite3_finalize(stmtcat);
+        db_log(spdlog::level::err, "Failed to bind directory_path: {}", sqlite3_errmsg(lease.db()));
         return categorized_files;
     }
 
+    if (include_subdirectories) {
+        auto [first, last] = subtree_range(directory_path);
+        sqlite3_bind_text(stmtcat, 2, first.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmtcat, 3, last.c_str(), -1, SQLITE_TRANSIENT);
+    }
+
     while (sqlite3_step(stmtcat) == SQLITE_ROW) {
         const char *file_dir_path = reinterpret_cast<const char *>(sqlite3_column_text(stmtcat, 0));
         const char *file_name = reinterpret_cast<const char *>(sqlite3_column_text(stmtcat, 1));
@@ -616,104 +932,258 @@ DatabaseManager::get_categorized_files(const std::string &directory_path) {
         categorized_files.push_back({dir_path, name, file_type_enum, cat, subcat, taxonomy_id});
     }
 
-    sqlite3_finalize(stmtcat);
     return categorized_files;
 }
 
-std::vector<std::string>
+std::optional<DatabaseManager::ResolvedCategory>
 DatabaseManager::get_categorization_from_db(const std::string &file_name, const FileType file_type) {
-    std::vector<std::string> categorization;
-    if (!db) return categorization;
+    if (!ensure_categorization_cache()) return std::nullopt;
 
-    const char *sql =
-        "SELECT category, subcategory FROM file_categorization WHERE file_name = ? AND file_type = ?;";
-    sqlite3_stmt *stmtcat = nullptr;
+    std::optional<ResolvedCategory> stored;
+    {
+        std::shared_lock<std::shared_mutex> lock(categorization_mutex);
+        if (const auto *cached = categorization_cache.find(file_name, file_type)) {
+            stored = ResolvedCategory{cached->taxonomy_id, cached->category, cached->subcategory};
+        }
+    }
+    if (!stored) {
+        return std::nullopt;
+    }
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmtcat, nullptr) != SQLITE_OK) {
-        return categorization;
+    // The stored id was resolved when the row was written; rows from before
+    // the taxonomy existed are resolved now.
+    std::shared_ptr<const TaxonomySnapshot> snapshot = std::atomic_load(&taxonomy);
+    if (const auto *entry = snapshot->find(stored->taxonomy_id)) {
+        return ResolvedCategory{entry->id, entry->category, entry->subcategory};
     }
+    return resolve_category(stored->category, stored->subcategory);
+}
+
+bool DatabaseManager::ensure_categorization_cache() {
+    if (!readers) return false;
+    if (categorization_cache_loaded.load(std::memory_order_acquire)) return true;
 
-    if (sqlite3_bind_text(stmtcat, 1, file_name.c_str(), -1, SQLITE_TRANSIENT) != SQLITE_OK) {
-        sqlite3_finalize(stmtcat);
-        return categorization;
+    // The first lookup loads the cache; lookups racing it wait here.
+    std::unique_lock<std::shared_mutex> lock(categorization_mutex);
+    if (!categorization_cache_loaded.load(std::memory_order_relaxed)) {
+        load_categorization_cache();
+        categorization_cache_loaded.store(true, std::memory_order_release);
     }
+    return true;
+}
+
+void DatabaseManager::load_categorization_cache() {
+    categorization_cache.clear();
+
+    auto lease = readers->acquire();
+    if (!lease) return;
+    sqlite3 *reader = lease.db();
 
-    std::string file_type_str = (file_type == FileType::File) ? "F" : "D";
-    if (sqlite3_bind_text(stmtcat, 2, file_type_str.c_str(), -1, SQLITE_TRANSIENT) != SQLITE_OK) {
-        sqlite3_finalize(stmtcat);
-        return categorization;
+    sqlite3_stmt *stmt = nullptr;
+    const char *count_sql = "SELECT COUNT(*) FROM file_categorization;";
+    if (sqlite3_prepare_v2(reader, count_sql, -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        categorization_cache.reserve(static_cast<size_t>(sqlite3_column_int64(stmt, 0)));
     }
+    if (stmt) sqlite3_finalize(stmt);
+    stmt = nullptr;
 
-    if (sqlite3_step(stmtcat) == SQLITE_ROW) {
-        const char *category = reinterpret_cast<const char *>(sqlite3_column_text(stmtcat, 0));
-        const char *subcategory = reinterpret_cast<const char *>(sqlite3_column_text(stmtcat, 1));
-        categorization.emplace_back(category ? category : "");
-        categorization.emplace_back(subcategory ? subcategory : "");
+    const char *select_sql =
+        "SELECT f.file_name, f.file_type, d.path, f.category, f.subcategory, f.taxonomy_id "
+        "FROM file_categorization f JOIN directories d ON d.id = f.dir_id;";
+    if (sqlite3_prepare_v2(reader, select_sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            auto text = [stmt](int column) {
+                const char *value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+                return std::string(value ? value : "");
+            };
+            categorization_cache.store({text(0),
+                                        text(1) == "F" ? FileType::File : FileType::Directory,
+                                        text(2),
+                                        text(3),
+                                        text(4),
+                                        sqlite3_column_int(stmt, 5)});
+        }
+        db_log(spdlog::level::debug, "Loaded {} categorization(s) into the cache",
+               categorization_cache.size());
+    } else {
+        db_log(spdlog::level::err, "Failed to load categorization cache: {}", sqlite3_errmsg(reader));
     }
+    if (stmt) sqlite3_finalize(stmt);
+}
 
-    sqlite3_finalize(stmtcat);
-    return categorization;
+void DatabaseManager::cache_categorization(const std::string &file_name,
+                                           const std::string &file_type,
+                                           const std::string &dir_path,
+                                           const ResolvedCategory &resolved) {
+    std::unique_lock<std::shared_mutex> lock(categorization_mutex);
+    // Until the first lookup loads the cache, the table is the only copy.
+    if (!categorization_cache_loaded.load(std::memory_order_relaxed)) {
+        return;
+    }
+    categorization_cache.store({file_name,
+                                file_type == "F" ? FileType::File : FileType::Directory,
+                                dir_path,
+                                resolved.category,
+                                resolved.subcategory,
+                                resolved.taxonomy_id > 0 ? resolved.taxonomy_id : 0});
+}
+
+void DatabaseManager::load_scan_snapshot(const std::string &directory_path,
+                                         bool include_subdirectories,
+                                         ScanSnapshotIndex &index) {
+    if (!readers) return;
+    auto lease = readers->acquire();
+    if (!lease) return;
+
+    // Without subdirectories the range is left empty.
+    auto [first, last] = subtree_range(directory_path);
+    if (!include_subdirectories) {
+        last = first;
+    }
+
+    auto bind = [&](sqlite3_stmt *stmt) {
+        sqlite3_bind_text(stmt, 1, directory_path.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, first.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, last.c_str(), -1, SQLITE_STATIC);
+    };
+
+    std::unordered_map<std::string, DirectorySnapshot> snapshots;
+    {
+        auto directories = statement(lease, Statement::SelectSnapshotDirectories);
+        if (!directories) {
+            return;
+        }
+        sqlite3_stmt *stmt = directories.get();
+        bind(stmt);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *dir_path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            DirectorySnapshot &snapshot = snapshots[dir_path ? dir_path : ""];
+            snapshot.inode = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 1));
+            snapshot.mtime_ns = sqlite3_column_int64(stmt, 2);
+            snapshot.scanned_at_ns = sqlite3_column_int64(stmt, 3);
+        }
+    }
+
+    if (snapshots.empty()) {
+        return;
+    }
+    auto entries = statement(lease, Statement::SelectSnapshotEntries);
+    if (!entries) {
+        return;
+    }
+    sqlite3_stmt *stmt = entries.get();
+    bind(stmt);
+    DirectorySnapshot *current = nullptr;
+    std::string current_path;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *dir_path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        const char *name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        if (!dir_path || !name) continue;
+
+        if (!current || current_path != dir_path) {
+            current_path = dir_path;
+            auto it = snapshots.find(current_path);
+            current = it != snapshots.end() ? &it->second : nullptr;
+        }
+        if (!current) continue;
+
+        current->entries.push_back({name,
+                                    static_cast<ScanEntryKind>(sqlite3_column_int(stmt, 2)),
+                                    sqlite3_column_int(stmt, 3) != 0,
+                                    sqlite3_column_int(stmt, 4) != 0});
+    }
+
+    for (auto &[dir_path, snapshot] : snapshots) {
+        index.load(dir_path, std::move(snapshot));
+    }
+    db_log(spdlog::level::debug, "Loaded scan snapshot for {} director(ies) under '{}'",
+           index.size(), directory_path);
+}
+
+bool DatabaseManager::save_scan_snapshot(ScanSnapshotIndex &index, bool prune_unvisited) {
+    if (!writer) return false;
+
+    std::vector<std::string> stale;
+    if (prune_unvisited) {
+        stale = index.unvisited_directories();
+    }
+    // Written in one transaction on the writer thread, after the
+    // categorization writes queued before it.
+    return writer->save_scan_snapshot(index.take_dirty(), std::move(stale));
 }
 
 bool DatabaseManager::is_file_already_categorized(const std::string &file_name) {
-    if (!db) return false;
+    // The cache holds every stored name, so no index on file_name is needed.
+    if (!ensure_categorization_cache()) return false;
 
-    const char *sql = "SELECT 1 FROM file_categorization WHERE file_name = ? LIMIT 1;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return false;
+    std::shared_lock<std::shared_mutex> lock(categorization_mutex);
+    return categorization_cache.find(file_name, FileType::File) ||
+           categorization_cache.find(file_name, FileType::Directory);
+}
+
+void DatabaseManager::add_sort_destination(const std::string &path) {
+    {
+        std::unique_lock<std::shared_mutex> lock(sort_destinations_mutex);
+        if (!sort_destinations.insert(path).second) {
+            return;
+        }
+    }
+    if (!writer || !writer->insert_sort_destination(path)) {
+        db_log(spdlog::level::warn, "Could not store sort destination '{}'", path);
     }
+}
+
+bool DatabaseManager::is_sort_destination(const std::string &path) const {
+    std::shared_lock<std::shared_mutex> lock(sort_destinations_mutex);
+    return sort_destinations.contains(path);
+}
 
-    sqlite3_bind_text(stmt, 1, file_name.c_str(), -1, SQLITE_TRANSIENT);
-    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+void DatabaseManager::load_sort_destinations() {
+    sqlite3_stmt *stmt = nullptr;
+    if (!db || sqlite3_prepare_v2(db, "SELECT path FROM sort_destination;", -1, &stmt, nullptr) != SQLITE_OK) {
+        db_log(spdlog::level::err, "Failed to load sort destinations: {}", db ? sqlite3_errmsg(db) : "no database");
+        sqlite3_finalize(stmt);
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(sort_destinations_mutex);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (const char *path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))) {
+            sort_destinations.emplace(path);
+        }
+    }
     sqlite3_finalize(stmt);
-    return exists;
 }
 
+
 std::vector<std::string> DatabaseManager::get_dir_contents_from_db(const std::string &dir_path) {
     std::vector<std::string> results;
-    if (!db) return results;
+    if (!readers) return results;
 
-    const char *sql = "SELECT file_name FROM file_categorization WHERE dir_path = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto lease = readers->acquire();
+    auto stmt = statement(lease, Statement::SelectDirContents);
+    if (!stmt) {
         return results;
     }
 
-    sqlite3_bind_text(stmt, 1, dir_path.c_str(), -1, SQLITE_TRANSIENT);
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const char *name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+    sqlite3_bind_text(stmt.get(), 1, dir_path.c_str(), -1, SQLITE_TRANSIENT);
+    while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        const char *name = reinterpret_cast<const char *>(sqlite3_column_text(stmt.get(), 0));
         results.emplace_back(name ? name : "");
     }
-    sqlite3_finalize(stmt);
     return results;
 }
 
-std::string DatabaseManager::get_cached_category(const std::string &file_name) {
-    auto iter = cached_results.find(file_name);
-    if (iter != cached_results.end()) {
-        return iter->second;
-    }
-    return {};
-}
-
-void DatabaseManager::load_cache() {
-    cached_results.clear();
-}
-
 bool DatabaseManager::file_exists_in_db(const std::string &file_name, const std::string &file_path) {
-    if (!db) return false;
+    if (!readers) return false;
 
-    const char *sql =
-        "SELECT 1 FROM file_categorization WHERE file_name = ? AND dir_path = ? LIMIT 1;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto lease = readers->acquire();
+    auto stmt = statement(lease, Statement::FileExists);
+    if (!stmt) {
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, file_name.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, file_path.c_str(), -1, SQLITE_TRANSIENT);
-    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
-    sqlite3_finalize(stmt);
-    return exists;
+    sqlite3_bind_text(stmt.get(), 1, file_name.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt.get(), 2, file_path.c_str(), -1, SQLITE_TRANSIENT);
+    return sqlite3_step(stmt.get()) == SQLITE_ROW;
 }
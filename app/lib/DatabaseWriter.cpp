@@ -0,0 +1,479 @@
+#include "DatabaseWriter.hpp"
+#include "Logger.hpp"
+
+#include <cstdio>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/fmt.h>
+
+namespace {
+
+// Queued requests beyond this wait for the next transaction.
+constexpr size_t kQueueCapacity = 4096;
+constexpr size_t kMaxGroupSize = 512;
+
+template <typename... Args>
+void writer_log(spdlog::level::level_enum level, const char* fmt, Args&&... args) {
+    auto message = fmt::format(fmt::runtime(fmt), std::forward<Args>(args)...);
+    if (auto logger = Logger::get_logger("core_logger")) {
+        logger->log(level, "{}", message);
+    } else {
+        std::fprintf(stderr, "%s\n", message.c_str());
+    }
+}
+
+// Resets the statement and clears its bindings when done with it.
+class StatementUse {
+public:
+    explicit StatementUse(sqlite3_stmt *stmt) : stmt(stmt) {}
+    ~StatementUse() {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    StatementUse(const StatementUse &) = delete;
+    StatementUse &operator=(const StatementUse &) = delete;
+
+    sqlite3_stmt *get() const { return stmt; }
+
+private:
+    sqlite3_stmt *stmt;
+};
+
+} // namespace
+
+
+DatabaseWriter::DatabaseWriter(const std::string &db_file,
+                               TaxonomyFailureCallback on_taxonomy_failure)
+    : queue(kQueueCapacity),
+      on_taxonomy_failure(std::move(on_taxonomy_failure))
+{
+    if (sqlite3_open(db_file.c_str(), &db) != SQLITE_OK) {
+        writer_log(spdlog::level::err, "Can't open database for writing: {}", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        db = nullptr;
+        return;
+    }
+    sqlite3_extended_result_codes(db, 1);
+    // The journal mode is stored in the database; synchronous is per connection.
+    exec("PRAGMA synchronous=NORMAL;");
+    sqlite3_busy_timeout(db, 5000);
+
+    upsert_file_stmt = prepare(R"(
+        INSERT INTO file_categorization
+            (dir_id, file_type, file_name, category, subcategory, taxonomy_id)
+        VALUES (?, ?, ?, ?, ?, ?)
+        ON CONFLICT(dir_id, file_type, file_name)
+        DO UPDATE SET
+            category = excluded.category,
+            subcategory = excluded.subcategory,
+            taxonomy_id = excluded.taxonomy_id;
+    )");
+    insert_alias_stmt = prepare(R"(
+        INSERT OR IGNORE INTO category_alias (alias_category_norm, alias_subcategory_norm, taxonomy_id)
+        VALUES (?, ?, ?);
+    )");
+    insert_taxonomy_stmt = prepare(R"(
+        INSERT INTO category_taxonomy
+            (id, canonical_category, canonical_subcategory, normalized_category, normalized_subcategory, frequency)
+        VALUES (?, ?, ?, ?, ?, 0);
+    )");
+    select_directory_stmt = prepare("SELECT id FROM directories WHERE path = ?;");
+    insert_directory_stmt = prepare("INSERT INTO directories (path) VALUES (?);");
+    insert_sort_destination_stmt = prepare("INSERT OR IGNORE INTO sort_destination (path) VALUES (?);");
+    upsert_scan_directory_stmt = prepare(
+        "INSERT OR REPLACE INTO scan_directory (dir_path, inode, mtime_ns, scanned_at_ns) "
+        "VALUES (?, ?, ?, ?);");
+    delete_scan_directory_stmt = prepare("DELETE FROM scan_directory WHERE dir_path = ?;");
+    delete_scan_entries_stmt = prepare("DELETE FROM scan_entry WHERE dir_path = ?;");
+    insert_scan_entry_stmt = prepare(
+        "INSERT INTO scan_entry (dir_path, name, kind, is_symlink, is_hidden) VALUES (?, ?, ?, ?, ?);");
+
+    if (!upsert_file_stmt || !insert_alias_stmt || !insert_taxonomy_stmt ||
+        !select_directory_stmt || !insert_directory_stmt || !insert_sort_destination_stmt ||
+        !upsert_scan_directory_stmt ||
+        !delete_scan_directory_stmt || !delete_scan_entries_stmt || !insert_scan_entry_stmt) {
+        finalize_statements();
+        sqlite3_close(db);
+        db = nullptr;
+        return;
+    }
+
+    thread = std::thread(&DatabaseWriter::run, this);
+}
+
+
+DatabaseWriter::~DatabaseWriter()
+{
+    queue.close();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (db) {
+        finalize_statements();
+        sqlite3_close(db);
+    }
+}
+
+
+bool DatabaseWriter::upsert_files(std::vector<FileRow> rows)
+{
+    if (rows.empty()) {
+        return true;
+    }
+    return db && queue.push(FileBatch{std::move(rows)});
+}
+
+
+bool DatabaseWriter::insert_alias(std::string norm_category, std::string norm_subcategory,
+                                  int taxonomy_id)
+{
+    return db && queue.push(AliasInsert{std::move(norm_category), std::move(norm_subcategory),
+                                        taxonomy_id});
+}
+
+
+bool DatabaseWriter::insert_taxonomy(int id, std::string category, std::string subcategory,
+                                     std::string norm_category, std::string norm_subcategory)
+{
+    return db && queue.push(TaxonomyInsert{id, std::move(category), std::move(subcategory),
+                                           std::move(norm_category), std::move(norm_subcategory)});
+}
+
+
+bool DatabaseWriter::insert_sort_destination(std::string path)
+{
+    return db && queue.push(SortDestinationInsert{std::move(path)});
+}
+
+
+bool DatabaseWriter::save_scan_snapshot(
+    std::vector<std::pair<std::string, ScanSnapshotIndex::SnapshotPtr>> listings,
+    std::vector<std::string> stale)
+{
+    if (listings.empty() && stale.empty()) {
+        return true;
+    }
+    return db && queue.push(ScanSnapshotSave{std::move(listings), std::move(stale)});
+}
+
+
+bool DatabaseWriter::flush()
+{
+    std::promise<bool> succeeded;
+    std::future<bool> result = succeeded.get_future();
+    if (!db || !queue.push(Barrier{std::move(succeeded)})) {
+        return false;
+    }
+    return result.get();
+}
+
+
+void DatabaseWriter::run()
+{
+    std::vector<Request> group;
+    while (auto request = queue.pop()) {
+        group.clear();
+        group.push_back(std::move(*request));
+        while (group.size() < kMaxGroupSize) {
+            auto next = queue.try_pop();
+            if (!next) break;
+            group.push_back(std::move(*next));
+        }
+        write_group(group);
+    }
+}
+
+
+void DatabaseWriter::write_group(std::vector<Request> &group)
+{
+    // A failing request is undone on its own and the rest of the group
+    // still commits.
+    const bool began = exec("BEGIN IMMEDIATE;");
+    std::vector<std::pair<Barrier *, bool>> barriers;
+    std::vector<int> failed_taxonomy_ids;
+    size_t failed = 0;
+
+    for (auto &request : group) {
+        if (auto *barrier = std::get_if<Barrier>(&request)) {
+            barriers.emplace_back(barrier, !failed_since_flush);
+            failed_since_flush = false;
+            continue;
+        }
+        if (!began) {
+            if (auto *taxonomy = std::get_if<TaxonomyInsert>(&request)) {
+                failed_taxonomy_ids.push_back(taxonomy->id);
+            }
+            failed_since_flush = true;
+            ++failed;
+            continue;
+        }
+
+        bool ok;
+        if (auto *batch = std::get_if<FileBatch>(&request)) {
+            // A failing statement undoes itself; only batches of several
+            // rows need a savepoint to be all or nothing.
+            const bool savepoint = batch->rows.size() > 1 && exec("SAVEPOINT batch;");
+            ok = write_files(*batch);
+            if (savepoint) {
+                if (!ok) {
+                    exec("ROLLBACK TO batch;");
+                    // Directories the batch added are gone again.
+                    directory_ids.clear();
+                }
+                exec("RELEASE batch;");
+            }
+        } else if (auto *alias = std::get_if<AliasInsert>(&request)) {
+            ok = write_alias(*alias);
+        } else if (auto *taxonomy = std::get_if<TaxonomyInsert>(&request)) {
+            ok = write_taxonomy(*taxonomy);
+            if (!ok) {
+                // Later requests in this group may already refer to it.
+                lost_taxonomy_ids.insert(taxonomy->id);
+                failed_taxonomy_ids.push_back(taxonomy->id);
+            }
+        } else if (auto *destination = std::get_if<SortDestinationInsert>(&request)) {
+            ok = write_sort_destination(*destination);
+        } else {
+            const bool savepoint = exec("SAVEPOINT snapshot;");
+            ok = savepoint && write_scan_snapshot(std::get<ScanSnapshotSave>(request));
+            if (savepoint) {
+                if (!ok) {
+                    exec("ROLLBACK TO snapshot;");
+                }
+                exec("RELEASE snapshot;");
+            }
+        }
+        if (!ok) {
+            failed_since_flush = true;
+            ++failed;
+        }
+    }
+
+    bool committed = began && exec("COMMIT;");
+    if (began && !committed) {
+        exec("ROLLBACK;");
+        directory_ids.clear();
+        failed_since_flush = true;
+        failed = group.size() - barriers.size();
+        for (auto &[barrier, succeeded] : barriers) {
+            succeeded = false;
+        }
+        failed_taxonomy_ids.clear();
+        for (const auto &request : group) {
+            if (const auto *taxonomy = std::get_if<TaxonomyInsert>(&request)) {
+                failed_taxonomy_ids.push_back(taxonomy->id);
+            }
+        }
+    }
+    if (failed > 0) {
+        writer_log(spdlog::level::err, "Failed to write {} of {} queued database request(s)",
+                   failed, group.size() - barriers.size());
+    }
+
+    // Reported before the barriers are released, so a flush that returns
+    // has also seen the entries dropped.
+    if (!failed_taxonomy_ids.empty()) {
+        lost_taxonomy_ids.insert(failed_taxonomy_ids.begin(), failed_taxonomy_ids.end());
+        if (on_taxonomy_failure) {
+            on_taxonomy_failure(failed_taxonomy_ids);
+        }
+    }
+
+    for (auto &[barrier, succeeded] : barriers) {
+        barrier->succeeded.set_value(succeeded);
+    }
+}
+
+
+bool DatabaseWriter::write_files(const FileBatch &batch)
+{
+    for (const auto &row : batch.rows) {
+        const sqlite3_int64 dir_id = directory_id(row.dir_path);
+        if (dir_id <= 0) {
+            return false;
+        }
+
+        StatementUse stmt(upsert_file_stmt);
+        sqlite3_bind_int64(stmt.get(), 1, dir_id);
+        sqlite3_bind_text(stmt.get(), 2, row.file_type.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt.get(), 3, row.file_name.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt.get(), 4, row.category.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt.get(), 5, row.subcategory.c_str(), -1, SQLITE_STATIC);
+        if (row.taxonomy_id > 0 && !lost_taxonomy_ids.contains(row.taxonomy_id)) {
+            sqlite3_bind_int(stmt.get(), 6, row.taxonomy_id);
+        } else {
+            sqlite3_bind_null(stmt.get(), 6);
+        }
+
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+            writer_log(spdlog::level::err, "SQL error during insert/update: {}", sqlite3_errmsg(db));
+            return false;
+        }
+    }
+    return true;
+}
+
+
+sqlite3_int64 DatabaseWriter::directory_id(const std::string &dir_path)
+{
+    if (auto it = directory_ids.find(dir_path); it != directory_ids.end()) {
+        return it->second;
+    }
+
+    sqlite3_int64 id = 0;
+    {
+        StatementUse stmt(select_directory_stmt);
+        sqlite3_bind_text(stmt.get(), 1, dir_path.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+            id = sqlite3_column_int64(stmt.get(), 0);
+        }
+    }
+    if (id == 0) {
+        StatementUse stmt(insert_directory_stmt);
+        sqlite3_bind_text(stmt.get(), 1, dir_path.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+            writer_log(spdlog::level::err, "Failed to insert directory '{}': {}", dir_path,
+                       sqlite3_errmsg(db));
+            return 0;
+        }
+        id = sqlite3_last_insert_rowid(db);
+    }
+    directory_ids.emplace(dir_path, id);
+    return id;
+}
+
+
+bool DatabaseWriter::write_alias(const AliasInsert &alias)
+{
+    if (lost_taxonomy_ids.contains(alias.taxonomy_id)) {
+        return true;
+    }
+    StatementUse stmt(insert_alias_stmt);
+    sqlite3_bind_text(stmt.get(), 1, alias.norm_category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt.get(), 2, alias.norm_subcategory.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt.get(), 3, alias.taxonomy_id);
+
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        writer_log(spdlog::level::err, "Failed to insert alias: {}", sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+
+bool DatabaseWriter::write_taxonomy(const TaxonomyInsert &taxonomy)
+{
+    StatementUse stmt(insert_taxonomy_stmt);
+    sqlite3_bind_int(stmt.get(), 1, taxonomy.id);
+    sqlite3_bind_text(stmt.get(), 2, taxonomy.category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt.get(), 3, taxonomy.subcategory.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt.get(), 4, taxonomy.norm_category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt.get(), 5, taxonomy.norm_subcategory.c_str(), -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        writer_log(spdlog::level::err, "Failed to insert taxonomy entry {}: {}", taxonomy.id,
+                   sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+
+bool DatabaseWriter::write_sort_destination(const SortDestinationInsert &destination)
+{
+    StatementUse stmt(insert_sort_destination_stmt);
+    sqlite3_bind_text(stmt.get(), 1, destination.path.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        writer_log(spdlog::level::err, "Failed to insert sort destination '{}': {}", destination.path,
+                   sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+
+bool DatabaseWriter::write_scan_snapshot(const ScanSnapshotSave &save)
+{
+    auto remove_entries = [&](const std::string &dir_path) {
+        StatementUse stmt(delete_scan_entries_stmt);
+        sqlite3_bind_text(stmt.get(), 1, dir_path.c_str(), -1, SQLITE_STATIC);
+        return sqlite3_step(stmt.get()) == SQLITE_DONE;
+    };
+
+    bool success = true;
+    for (const auto &[dir_path, snapshot] : save.listings) {
+        {
+            StatementUse stmt(upsert_scan_directory_stmt);
+            sqlite3_bind_text(stmt.get(), 1, dir_path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt.get(), 2, static_cast<sqlite3_int64>(snapshot->inode));
+            sqlite3_bind_int64(stmt.get(), 3, snapshot->mtime_ns);
+            sqlite3_bind_int64(stmt.get(), 4, snapshot->scanned_at_ns);
+            success = sqlite3_step(stmt.get()) == SQLITE_DONE;
+        }
+        success = success && remove_entries(dir_path);
+
+        for (const auto &entry : snapshot->entries) {
+            if (!success) break;
+            StatementUse stmt(insert_scan_entry_stmt);
+            sqlite3_bind_text(stmt.get(), 1, dir_path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt.get(), 2, entry.name.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt.get(), 3, static_cast<int>(entry.kind));
+            sqlite3_bind_int(stmt.get(), 4, entry.is_symlink ? 1 : 0);
+            sqlite3_bind_int(stmt.get(), 5, entry.is_hidden ? 1 : 0);
+            success = sqlite3_step(stmt.get()) == SQLITE_DONE;
+        }
+        if (!success) break;
+    }
+
+    for (size_t i = 0; success && i < save.stale.size(); ++i) {
+        StatementUse stmt(delete_scan_directory_stmt);
+        sqlite3_bind_text(stmt.get(), 1, save.stale[i].c_str(), -1, SQLITE_STATIC);
+        success = sqlite3_step(stmt.get()) == SQLITE_DONE && remove_entries(save.stale[i]);
+    }
+
+    if (!success) {
+        writer_log(spdlog::level::err, "Failed to save scan snapshot: {}", sqlite3_errmsg(db));
+    } else {
+        writer_log(spdlog::level::debug, "Saved {} scan snapshot listing(s), pruned {}",
+                   save.listings.size(), save.stale.size());
+    }
+    return success;
+}
+
+
+bool DatabaseWriter::exec(const char *sql)
+{
+    char *error_msg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
+        writer_log(spdlog::level::err, "Database writer failed to run '{}': {}", sql,
+                   error_msg ? error_msg : sqlite3_errmsg(db));
+        sqlite3_free(error_msg);
+        return false;
+    }
+    return true;
+}
+
+
+sqlite3_stmt *DatabaseWriter::prepare(const char *sql)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        writer_log(spdlog::level::err, "Failed to prepare statement: {}", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    return stmt;
+}
+
+
+void DatabaseWriter::finalize_statements()
+{
+    for (sqlite3_stmt *stmt : {upsert_file_stmt, insert_alias_stmt, insert_taxonomy_stmt,
+                               select_directory_stmt, insert_directory_stmt,
+                               insert_sort_destination_stmt, upsert_scan_directory_stmt,
+                               delete_scan_directory_stmt, delete_scan_entries_stmt,
+                               insert_scan_entry_stmt}) {
+        sqlite3_finalize(stmt);
+    }
+}
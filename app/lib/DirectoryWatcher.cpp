@@ -0,0 +1,388 @@
+#include "DirectoryWatcher.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+#ifdef __linux__
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+#endif
+
+// A steady stream of events must not postpone a batch forever.
+constexpr int kMaxDebounceFactor = 10;
+}
+
+
+DirectoryWatcher::DirectoryWatcher(std::chrono::milliseconds debounce)
+    : debounce(debounce)
+{
+}
+
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    stop();
+}
+
+
+bool DirectoryWatcher::is_supported()
+{
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool DirectoryWatcher::start(const std::string &directory_path, FileScanOptions options,
+                             int max_depth, BatchCallback on_batch,
+                             std::shared_ptr<const NameFilter> filter)
+{
+    stop();
+    auto logger = Logger::get_logger("core_logger");
+
+#ifdef __linux__
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd < 0 || wake_fd < 0) {
+        if (logger) {
+            logger->error("Failed to initialize folder watch: {}", std::strerror(errno));
+        }
+        close_descriptors();
+        return false;
+    }
+
+    this->options = options;
+    this->max_depth = max_depth;
+    this->filter = filter && !filter->empty() ? std::move(filter) : nullptr;
+    this->on_batch = std::move(on_batch);
+    paths = std::make_shared<PathTable>();
+    names = &paths->make_arena();
+
+    if (!add_watch(directory_path, 0)) {
+        close_descriptors();
+        return false;
+    }
+    if (has_flag(options, FileScanOptions::Recursive)) {
+        add_subdirectory_watches(directory_path);
+    }
+
+    running = true;
+    exited = false;
+    worker = std::thread(&DirectoryWatcher::run, this);
+    if (logger) {
+        logger->info("Watching '{}' ({} director(ies))", directory_path, watches.size());
+    }
+    return true;
+#else
+    (void)directory_path;
+    (void)options;
+    (void)max_depth;
+    (void)on_batch;
+    (void)filter;
+    if (logger) {
+        logger->warn("Folder watch is not supported on this platform.");
+    }
+    return false;
+#endif
+}
+
+
+void DirectoryWatcher::stop()
+{
+    if (!worker.joinable()) {
+        close_descriptors();
+        return;
+    }
+
+    request_stop();
+    worker.join();
+
+    // Files still waiting for the debounce are dropped; the next analysis
+    // picks them up like any other uncategorized file.
+    pending.clear();
+    pending_paths.clear();
+    names = nullptr;
+    paths.reset();
+    watches.clear();
+    close_descriptors();
+}
+
+
+void DirectoryWatcher::request_stop()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    running = false;
+#ifdef __linux__
+    uint64_t wake = 1;
+    if (::write(wake_fd, &wake, sizeof(wake)) < 0) {
+        // The running flag is still checked after every poll timeout.
+    }
+#endif
+}
+
+
+bool DirectoryWatcher::is_running() const
+{
+    return running.load();
+}
+
+
+bool DirectoryWatcher::is_stopping() const
+{
+    return worker.joinable() && !running.load() && !exited.load();
+}
+
+
+void DirectoryWatcher::run()
+{
+#ifdef __linux__
+    using clock = std::chrono::steady_clock;
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    clock::time_point first_event;
+    clock::time_point last_event;
+    auto logger = Logger::get_logger("core_logger");
+
+    while (running.load()) {
+        int timeout_ms = -1;
+        if (!pending.empty()) {
+            auto deadline = std::min(last_event + debounce, first_event + debounce * kMaxDebounceFactor);
+            auto now = clock::now();
+            if (now >= deadline) {
+                flush_pending();
+                continue;
+            }
+            timeout_ms = static_cast<int>(
+                std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+        }
+
+        pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+        int ready = ::poll(fds, 2, timeout_ms);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            if (logger) {
+                logger->error("Folder watch stopped: {}", std::strerror(errno));
+            }
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        ssize_t length = ::read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            continue;
+        }
+
+        const bool was_idle = pending.empty();
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            auto *event = reinterpret_cast<struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+            handle_event(event->wd, event->mask, event->len ? event->name : "");
+        }
+
+        last_event = clock::now();
+        if (was_idle) {
+            first_event = last_event;
+        }
+    }
+    running = false;
+#endif
+    exited = true;
+}
+
+
+void DirectoryWatcher::set_pruned_directories(FileScanner::DirectoryPredicate is_pruned)
+{
+    pruned_directories = std::move(is_pruned);
+}
+
+
+bool DirectoryWatcher::is_pruned(const std::string &dir_path) const
+{
+    if (!pruned_directories || !pruned_directories(dir_path)) {
+        return false;
+    }
+    if (auto logger = Logger::get_logger("core_logger")) {
+        logger->info("Not watching '{}': it was created by sorting", dir_path);
+    }
+    return true;
+}
+
+
+bool DirectoryWatcher::add_watch(const std::string &dir_path, int depth)
+{
+#ifdef __linux__
+    int wd = inotify_add_watch(inotify_fd, dir_path.c_str(), kWatchMask);
+    if (wd < 0) {
+        if (auto logger = Logger::get_logger("core_logger")) {
+            // ENOSPC here means fs.inotify.max_user_watches is exhausted.
+            logger->warn("Cannot watch '{}': {}", dir_path, std::strerror(errno));
+        }
+        return false;
+    }
+    watches[wd] = WatchedDirectory{dir_path, depth};
+    return true;
+#else
+    (void)dir_path;
+    (void)depth;
+    return false;
+#endif
+}
+
+
+void DirectoryWatcher::add_subdirectory_watches(const std::string &dir_path)
+{
+    // Mirrors FileScanner: hidden directories are skipped unless hidden files
+    // are included, excluded names and symlinked directories are not
+    // followed, and max_depth counts levels below the watched folder.
+    std::error_code ec;
+    auto it = fs::recursive_directory_iterator(dir_path, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        const bool hidden = name.starts_with(".");
+        if (it->is_symlink(ec) || !it->is_directory(ec) ||
+            (hidden && !has_flag(options, FileScanOptions::HiddenFiles)) ||
+            (filter && filter->is_excluded(name))) {
+            it.disable_recursion_pending();
+            continue;
+        }
+
+        const std::string path = it->path().string();
+        if (is_pruned(path)) {
+            it.disable_recursion_pending();
+            continue;
+        }
+
+        int depth = it.depth() + 1;
+        add_watch(path, depth);
+        if (max_depth > 0 && depth >= max_depth) {
+            it.disable_recursion_pending();
+        }
+    }
+}
+
+
+void DirectoryWatcher::handle_event(int wd, uint32_t mask, const char *name)
+{
+#ifdef __linux__
+    if (mask & IN_Q_OVERFLOW) {
+        if (auto logger = Logger::get_logger("core_logger")) {
+            logger->warn("Folder watch missed events; analyze the folder to catch up.");
+        }
+        return;
+    }
+    if (mask & IN_IGNORED) {
+        watches.erase(wd);
+        return;
+    }
+
+    auto it = watches.find(wd);
+    if (it == watches.end() || *name == '\0') {
+        return;
+    }
+
+    std::string_view file_name(name);
+    if (FileScanner::is_junk_file(file_name) ||
+        (file_name.front() == '.' && !has_flag(options, FileScanOptions::HiddenFiles))) {
+        return;
+    }
+
+    const WatchedDirectory &parent = it->second;
+    const bool as_file = !(mask & IN_ISDIR) || FileScanner::is_file_bundle(file_name);
+    if (filter && (as_file ? !filter->accepts_file(file_name) : filter->is_excluded(file_name))) {
+        return;
+    }
+
+    if (mask & IN_ISDIR) {
+        // Sorting records its folders before creating them, so files moved
+        // into one are never seen here.
+        const std::string dir_path = (fs::path(parent.path) / file_name).string();
+        if (is_pruned(dir_path)) {
+            return;
+        }
+        if (has_flag(options, FileScanOptions::Recursive) &&
+            (max_depth <= 0 || parent.depth < max_depth)) {
+            // Files written before this watch exists are left to the next analysis.
+            add_watch(dir_path, parent.depth + 1);
+        }
+        if (FileScanner::is_file_bundle(file_name)) {
+            if (has_flag(options, FileScanOptions::Files)) {
+                queue_entry(parent.path, file_name, FileType::File);
+            }
+        } else if (has_flag(options, FileScanOptions::Directories)) {
+            queue_entry(parent.path, file_name, FileType::Directory);
+        }
+        return;
+    }
+
+    // A plain IN_CREATE is followed by IN_CLOSE_WRITE once the file is complete.
+    if ((mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && has_flag(options, FileScanOptions::Files)) {
+        queue_entry(parent.path, file_name, FileType::File);
+    }
+#else
+    (void)wd;
+    (void)mask;
+    (void)name;
+#endif
+}
+
+
+void DirectoryWatcher::queue_entry(const std::string &dir_path, std::string_view file_name, FileType type)
+{
+    FileEntry entry{paths, paths->intern_directory(dir_path), file_name, type};
+    if (pending_paths.insert(entry.full_path()).second) {
+        entry.file_name = names->store(file_name);
+        pending.push_back(std::move(entry));
+    }
+}
+
+
+void DirectoryWatcher::flush_pending()
+{
+    std::vector<FileEntry> batch;
+    batch.swap(pending);
+    pending_paths.clear();
+    paths = std::make_shared<PathTable>();
+    names = &paths->make_arena();
+
+    if (auto logger = Logger::get_logger("core_logger")) {
+        logger->debug("Folder watch collected {} new item(s)", batch.size());
+    }
+    if (on_batch) {
+        on_batch(std::move(batch));
+    }
+}
+
+
+void DirectoryWatcher::close_descriptors()
+{
+#ifdef __linux__
+    if (inotify_fd >= 0) {
+        ::close(inotify_fd);
+    }
+    if (wake_fd >= 0) {
+        ::close(wake_fd);
+    }
+#endif
+    inotify_fd = -1;
+    wake_fd = -1;
+}
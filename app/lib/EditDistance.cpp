@@ -0,0 +1,215 @@
+#include "EditDistance.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace {
+
+constexpr size_t kWordBits = 64;
+
+// Per-thread scratch. peq holds, for every byte value, the positions at
+// which it occurs in the pattern; only the bytes of the current pattern are
+// set, and they are cleared again before returning.
+struct Workspace {
+    std::array<std::uint64_t, 256> peq{};
+    std::vector<std::uint64_t> block_peq;  // 256 rows of `blocks` words
+    std::vector<std::uint64_t> positive;
+    std::vector<std::uint64_t> negative;
+};
+
+thread_local Workspace workspace;
+
+// Once the text has `remaining` characters left, the bottom row of the
+// matrix can drop by at most that much.
+inline bool out_of_reach(size_t score, size_t remaining, size_t max_distance)
+{
+    return score > max_distance && score - max_distance > remaining;
+}
+
+} // namespace
+
+
+size_t EditDistance::levenshtein(std::string_view a, std::string_view b, size_t max_distance)
+{
+    // A shared prefix or suffix never changes the distance.
+    size_t prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) {
+        ++prefix;
+    }
+    a.remove_prefix(prefix);
+    b.remove_prefix(prefix);
+    while (!a.empty() && !b.empty() && a.back() == b.back()) {
+        a.remove_suffix(1);
+        b.remove_suffix(1);
+    }
+
+    // The shorter string is the pattern, so it spans as few words as possible.
+    if (a.size() > b.size()) {
+        std::swap(a, b);
+    }
+    const size_t overflow = max_distance == kUnbounded ? kUnbounded : max_distance + 1;
+    if (b.size() - a.size() > max_distance) {
+        return overflow;
+    }
+    if (a.empty()) {
+        return b.size();
+    }
+
+    size_t distance = a.size() <= kWordBits ? single_word(a, b, max_distance)
+                                            : multi_word(a, b, max_distance);
+    return distance > max_distance ? overflow : distance;
+}
+
+
+double EditDistance::similarity(std::string_view a, std::string_view b, double min_similarity)
+{
+    if (a == b) {
+        return 1.0;
+    }
+    if (a.empty() || b.empty()) {
+        return 0.0;
+    }
+
+    const size_t longer = std::max(a.size(), b.size());
+    const double length = static_cast<double>(longer);
+    size_t max_distance = longer;
+    if (min_similarity > 0.0) {
+        // Largest distance whose score still reaches min_similarity, adjusted
+        // so that it agrees with the floating point comparison callers make.
+        double allowed = (1.0 - min_similarity) * length;
+        max_distance = allowed <= 0.0 ? 0 : std::min(longer, static_cast<size_t>(allowed));
+        while (max_distance < longer &&
+               1.0 - static_cast<double>(max_distance + 1) / length >= min_similarity) {
+            ++max_distance;
+        }
+        while (max_distance > 0 &&
+               1.0 - static_cast<double>(max_distance) / length < min_similarity) {
+            --max_distance;
+        }
+        if (1.0 - static_cast<double>(max_distance) / length < min_similarity) {
+            return 0.0;
+        }
+    }
+
+    size_t distance = levenshtein(a, b, max_distance);
+    if (distance > max_distance) {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(distance) / length;
+}
+
+
+size_t EditDistance::single_word(std::string_view pattern, std::string_view text,
+                                 size_t max_distance)
+{
+    auto &peq = workspace.peq;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        peq[static_cast<unsigned char>(pattern[i])] |= std::uint64_t{1} << i;
+    }
+
+    // Bit i of positive/negative is set when D[i+1][j] - D[i][j] is +1/-1;
+    // score tracks the bottom row D[m][j].
+    const std::uint64_t last = std::uint64_t{1} << (pattern.size() - 1);
+    std::uint64_t positive = ~std::uint64_t{0};
+    std::uint64_t negative = 0;
+    size_t score = pattern.size();
+
+    for (size_t j = 0; j < text.size(); ++j) {
+        const std::uint64_t eq = peq[static_cast<unsigned char>(text[j])];
+        const std::uint64_t xv = eq | negative;
+        const std::uint64_t xh = (((eq & positive) + positive) ^ positive) | eq;
+        std::uint64_t hp = negative | ~(xh | positive);
+        std::uint64_t hn = positive & xh;
+
+        if (hp & last) {
+            ++score;
+        } else if (hn & last) {
+            --score;
+        }
+        if (out_of_reach(score, text.size() - j - 1, max_distance)) {
+            break;
+        }
+
+        // The top row is D[0][j] = j, so it always steps up by one.
+        hp = (hp << 1) | 1;
+        hn <<= 1;
+        positive = hn | ~(xv | hp);
+        negative = hp & xv;
+    }
+
+    for (char ch : pattern) {
+        peq[static_cast<unsigned char>(ch)] = 0;
+    }
+    return score;
+}
+
+
+size_t EditDistance::multi_word(std::string_view pattern, std::string_view text,
+                                size_t max_distance)
+{
+    const size_t blocks = (pattern.size() + kWordBits - 1) / kWordBits;
+    auto &peq = workspace.block_peq;
+    auto &positive = workspace.positive;
+    auto &negative = workspace.negative;
+    if (peq.size() < 256 * blocks) {
+        peq.assign(256 * blocks, 0);
+    }
+    positive.assign(blocks, ~std::uint64_t{0});
+    negative.assign(blocks, 0);
+
+    auto row = [&](unsigned char ch) { return peq.data() + static_cast<size_t>(ch) * blocks; };
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        row(static_cast<unsigned char>(pattern[i]))[i / kWordBits] |=
+            std::uint64_t{1} << (i % kWordBits);
+    }
+
+    const std::uint64_t last = std::uint64_t{1} << ((pattern.size() - 1) % kWordBits);
+    size_t score = pattern.size();
+
+    for (size_t j = 0; j < text.size(); ++j) {
+        const std::uint64_t *eqs = row(static_cast<unsigned char>(text[j]));
+        // Horizontal delta entering the block from above: +1 at the top row.
+        int carry = 1;
+        for (size_t b = 0; b < blocks; ++b) {
+            std::uint64_t eq = eqs[b];
+            const std::uint64_t pv = positive[b];
+            const std::uint64_t mv = negative[b];
+            const std::uint64_t xv = eq | mv;
+            if (carry < 0) {
+                eq |= 1;
+            }
+            const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            std::uint64_t hp = mv | ~(xh | pv);
+            std::uint64_t hn = pv & xh;
+
+            const std::uint64_t high = b + 1 == blocks ? last : std::uint64_t{1} << (kWordBits - 1);
+            const int carry_out = (hp & high) ? 1 : (hn & high) ? -1 : 0;
+
+            hp <<= 1;
+            hn <<= 1;
+            if (carry < 0) {
+                hn |= 1;
+            } else if (carry > 0) {
+                hp |= 1;
+            }
+            positive[b] = hn | ~(xv | hp);
+            negative[b] = hp & xv;
+            carry = carry_out;
+        }
+
+        if (carry > 0) {
+            ++score;
+        } else if (carry < 0) {
+            --score;
+        }
+        if (out_of_reach(score, text.size() - j - 1, max_distance)) {
+            break;
+        }
+    }
+
+    for (char ch : pattern) {
+        std::fill_n(row(static_cast<unsigned char>(ch)), blocks, 0);
+    }
+    return score;
+}
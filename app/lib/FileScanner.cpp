@@ -1,8 +1,19 @@
 #include "FileScanner.hpp"
 #include "Logger.hpp"
+#include "NameFilter.hpp"
+#include "PathTable.hpp"
+#include "ScanSnapshot.hpp"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
 #include <unordered_set>
 #include <gtk/gtk.h>
 
@@ -10,102 +21,618 @@
 #include <windows.h>
 #endif
 
+#ifdef __linux__
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
+namespace {
+
+// One deque per worker: the owner pushes and pops at the back (depth-first,
+// cache friendly), idle workers steal from the front of other deques and
+// sleep while every deque is empty.
+template <typename Task>
+class WorkStealingQueues {
+public:
+    explicit WorkStealingQueues(size_t worker_count) : queues(worker_count) {}
+
+    void push(size_t worker, Task task) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            queues[worker].tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            ++queued;
+        }
+        idle.notify_one();
+    }
+
+    // Blocks until a task is available; returns false once all work is done.
+    bool pop(size_t worker, Task &task) {
+        for (;;) {
+            if (try_pop(worker, task)) {
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                --queued;
+                return true;
+            }
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            idle.wait(lock, [this] {
+                return queued > 0 || pending.load(std::memory_order_acquire) == 0;
+            });
+            if (queued == 0) {
+                return false;
+            }
+        }
+    }
+
+    // Called once a popped task (and the pushes it made) is finished.
+    void complete() {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            idle.notify_all();
+        }
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool try_pop(size_t worker, Task &task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            if (!queues[worker].tasks.empty()) {
+                task = std::move(queues[worker].tasks.back());
+                queues[worker].tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            auto &victim = queues[(worker + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<WorkerQueue> queues;
+    // Tasks pushed but not yet completed.
+    std::atomic<size_t> pending{0};
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    // Tasks sitting in a deque; guarded by idle_mutex.
+    size_t queued{0};
+};
+
+
+using EntryKind = ScanEntryKind;
+
+// Type information for one directory entry. Symlinks are resolved, so kind
+// describes the link target while is_symlink records the link itself.
+struct RawEntry {
+    std::string_view name;
+    EntryKind kind;
+    bool is_symlink;
+    bool is_hidden;
+};
+
+// Identity and modification time of a directory, plus when they were read.
+struct DirectoryStamp {
+    std::uint64_t inode{0};
+    std::int64_t mtime_ns{0};
+    std::int64_t taken_at_ns{0};
+};
+
+// A listing is only trusted if the directory had not been modified for this
+// long when it was read; changes within the filesystem's timestamp
+// granularity would otherwise leave the mtime unchanged.
+constexpr std::int64_t kSnapshotSettleNs = 2'000'000'000;
+
+#ifdef __linux__
+struct linux_dirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Closes the directory however its listing ends, including when a visitor
+// throws.
+class DirectoryFd {
+public:
+    explicit DirectoryFd(int fd) : fd(fd) {}
+    ~DirectoryFd() { if (fd >= 0) ::close(fd); }
+    DirectoryFd(const DirectoryFd &) = delete;
+    DirectoryFd &operator=(const DirectoryFd &) = delete;
+
+    int get() const { return fd; }
+
+private:
+    int fd;
+};
+
+EntryKind kind_from_mode(mode_t mode) {
+    if (S_ISREG(mode)) return EntryKind::Regular;
+    if (S_ISDIR(mode)) return EntryKind::Directory;
+    return EntryKind::Other;
+}
+
+// Only reached for DT_LNK and DT_UNKNOWN entries; reports the file type of
+// name relative to dir_fd, following symlinks when follow is set.
+bool stat_entry_mode(int dir_fd, const char *name, bool follow, mode_t &mode) {
+    const int flags = follow ? 0 : AT_SYMLINK_NOFOLLOW;
+#ifdef STATX_TYPE
+    struct statx stx;
+    if (statx(dir_fd, name, flags | AT_STATX_DONT_SYNC, STATX_TYPE, &stx) != 0) {
+        return false;
+    }
+    mode = stx.stx_mode;
+#else
+    struct stat st;
+    if (fstatat(dir_fd, name, &st, flags) != 0) {
+        return false;
+    }
+    mode = st.st_mode;
+#endif
+    return true;
+}
+
+std::int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+bool read_directory_stamp(const fs::path &directory, DirectoryStamp &stamp) {
+    stamp.taken_at_ns = now_ns();
+#ifdef STATX_TYPE
+    struct statx stx;
+    if (statx(AT_FDCWD, directory.c_str(), AT_STATX_DONT_SYNC, STATX_INO | STATX_MTIME, &stx) != 0) {
+        return false;
+    }
+    stamp.inode = stx.stx_ino;
+    stamp.mtime_ns = static_cast<std::int64_t>(stx.stx_mtime.tv_sec) * 1'000'000'000 + stx.stx_mtime.tv_nsec;
+#else
+    struct stat st;
+    if (::stat(directory.c_str(), &st) != 0) {
+        return false;
+    }
+    stamp.inode = st.st_ino;
+    stamp.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+// Reads raw getdents64 records and classifies entries from d_type, so the
+// common case costs no per-entry stat call at all.
+template <typename Visitor>
+void for_each_entry(const fs::path &directory, Visitor &&visit) {
+    const DirectoryFd fd(::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    const int dir_fd = fd.get();
+    if (dir_fd < 0) {
+        throw fs::filesystem_error("Cannot open directory", directory,
+                                   std::error_code(errno, std::generic_category()));
+    }
+
+    alignas(linux_dirent64) static thread_local char buffer[64 * 1024];
+    for (;;) {
+        long bytes = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer));
+        if (bytes < 0) {
+            int err = errno;
+            throw fs::filesystem_error("Cannot read directory", directory,
+                                       std::error_code(err, std::generic_category()));
+        }
+        if (bytes == 0) break;
+
+        for (long offset = 0; offset < bytes;) {
+            auto *record = reinterpret_cast<linux_dirent64 *>(buffer + offset);
+            offset += record->d_reclen;
+
+            std::string_view name(record->d_name);
+            if (name == "." || name == "..") continue;
+
+            RawEntry entry{name, EntryKind::Other, false, name.front() == '.'};
+            mode_t mode = 0;
+            switch (record->d_type) {
+                case DT_REG: entry.kind = EntryKind::Regular; break;
+                case DT_DIR: entry.kind = EntryKind::Directory; break;
+                case DT_LNK:
+                    entry.is_symlink = true;
+                    if (stat_entry_mode(dir_fd, record->d_name, true, mode)) {
+                        entry.kind = kind_from_mode(mode);
+                    }
+                    break;
+                case DT_UNKNOWN:
+                    // Some filesystems (older XFS, certain network/FUSE mounts) leave d_type empty.
+                    if (stat_entry_mode(dir_fd, record->d_name, false, mode)) {
+                        if (S_ISLNK(mode)) {
+                            entry.is_symlink = true;
+                            if (stat_entry_mode(dir_fd, record->d_name, true, mode)) {
+                                entry.kind = kind_from_mode(mode);
+                            }
+                        } else {
+                            entry.kind = kind_from_mode(mode);
+                        }
+                    }
+                    break;
+                default: break;
+            }
+            visit(entry);
+        }
+    }
+}
+#else
+bool is_file_hidden(const fs::path &path) {
+#ifdef _WIN32
+    DWORD attrs = GetFileAttributesW(path.c_str());
+    return (attrs != INVALID_FILE_ATTRIBUTES) &&
+           (attrs & FILE_ATTRIBUTE_HIDDEN);
+#else
+    return path.filename().string().starts_with(".");
+#endif
+}
+
+std::int64_t to_ns(fs::file_time_type time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// std::filesystem exposes no inode number, so only the mtime identifies a
+// directory here; the file clock keeps it comparable with taken_at_ns.
+bool read_directory_stamp(const fs::path &directory, DirectoryStamp &stamp) {
+    stamp.taken_at_ns = to_ns(fs::file_time_type::clock::now());
+    std::error_code ec;
+    auto mtime = fs::last_write_time(directory, ec);
+    if (ec) {
+        return false;
+    }
+    stamp.inode = 0;
+    stamp.mtime_ns = to_ns(mtime);
+    return true;
+}
+
+// Portable backend: directory_entry caches the type reported by the
+// directory listing, so only symlinks need an extra status call.
+template <typename Visitor>
+void for_each_entry(const fs::path &directory, Visitor &&visit) {
+    for (const auto &entry : fs::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        std::error_code ec;
+        RawEntry raw{name, EntryKind::Other, entry.is_symlink(ec), is_file_hidden(entry.path())};
+        if (entry.is_regular_file(ec)) {
+            raw.kind = EntryKind::Regular;
+        } else if (entry.is_directory(ec)) {
+            raw.kind = EntryKind::Directory;
+        }
+        visit(raw);
+    }
+}
+#endif
+
+constexpr size_t kEntryBatchSize = 256;
+
+} // namespace
+
+
+// Shared state of one scan; entries reach the consumer in batches so that
+// worker threads take the delivery lock once per batch, not once per entry.
+struct FileScanner::ScanContext {
+    FileScanOptions options;
+    int max_depth;
+    const EntryCallback &on_entry;
+    ScanSnapshotIndex *snapshot;
+    std::shared_ptr<PathTable> paths;
+    std::shared_ptr<const NameFilter> filter;
+    FileScanner::DirectoryPredicate pruned_directories;
+    std::mutex mutex;
+    std::atomic<bool> cancelled{false};
+    std::atomic<size_t> reused_directories{0};
+    size_t delivered{0};
+
+    void flush(std::vector<FileEntry> &batch) {
+        if (batch.empty()) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &entry : batch) {
+            if (cancelled.load(std::memory_order_relaxed)) break;
+            if (on_entry(std::move(entry))) {
+                ++delivered;
+            } else {
+                cancelled.store(true, std::memory_order_relaxed);
+            }
+        }
+        batch.clear();
+    }
+};
+
 
 std::vector<FileEntry>
 FileScanner::get_directory_entries(const std::string &directory_path,
-                                   FileScanOptions options)
+                                   FileScanOptions options,
+                                   int max_depth)
 {
     std::vector<FileEntry> file_paths_and_names;
+    scan_directory_entries(directory_path, options, [&](FileEntry &&entry) {
+        file_paths_and_names.push_back(std::move(entry));
+        return true;
+    }, max_depth);
+    return file_paths_and_names;
+}
+
+
+bool FileScanner::scan_directory_entries(const std::string &directory_path,
+                                         FileScanOptions options,
+                                         const EntryCallback &on_entry,
+                                         int max_depth,
+                                         ScanSnapshotIndex *snapshot)
+{
+    ScanContext context{options, max_depth, on_entry, snapshot, std::make_shared<PathTable>(),
+                        name_filter && !name_filter->empty() ? name_filter : nullptr,
+                        pruned_directories};
+    std::vector<FileEntry> batch;
+    std::vector<ScanTask> subdirectories;
     auto logger = Logger::get_logger("core_logger");
 
     if (logger) {
         logger->debug("Scanning directory '{}' with options mask {}", directory_path, static_cast<int>(options));
     }
 
+    // Entries report their directory as stored in the path table, so a
+    // trailing separator on the root would leak into every top-level entry.
+    std::string root = directory_path;
+    while (root.size() > 1 && root.back() == static_cast<char>(fs::path::preferred_separator)) {
+        root.pop_back();
+    }
+
     try {
-        for (const auto &entry : fs::directory_iterator(directory_path)) {
-            std::string full_path = entry.path().string();
-            std::string file_name = entry.path().filename().string();
-            bool is_hidden = is_file_hidden(full_path);
-            bool should_add = false;
-            FileType file_type;
-
-            if (is_junk_file(file_name)) continue;
-
-            if (is_file_bundle(entry)) {
-                if (has_flag(options, FileScanOptions::Files) &&
-                    (has_flag(options, FileScanOptions::HiddenFiles) || !is_hidden)) {
-                    file_type = FileType::File;
-                    should_add = true;
-                }
+        scan_directory(root, 0, context, context.paths->make_arena(), batch, subdirectories);
+    } catch (const fs::filesystem_error& ex) {
+        if (logger) {
+            logger->warn("Error while scanning '{}': {}", directory_path, ex.what());
+        }
+        throw;
+    }
+    context.flush(batch);
+
+    if (!subdirectories.empty() && !context.cancelled) {
+        scan_recursive(std::move(subdirectories), context);
+    }
+
+    if (logger) {
+        logger->info("Directory scan {} for '{}': {} item(s) queued",
+                     context.cancelled ? "stopped" : "complete", directory_path,
+                     context.delivered);
+        if (snapshot) {
+            logger->debug("{} directory listing(s) reused from the scan snapshot",
+                          context.reused_directories.load());
+        }
+    }
+    return !context.cancelled;
+}
+
+
+void FileScanner::set_thread_count(unsigned int count)
+{
+    thread_count = count;
+}
+
+
+void FileScanner::set_name_filter(std::shared_ptr<const NameFilter> filter)
+{
+    name_filter = std::move(filter);
+}
+
+
+void FileScanner::set_pruned_directories(DirectoryPredicate is_pruned)
+{
+    pruned_directories = std::move(is_pruned);
+}
+
+
+void FileScanner::scan_directory(const fs::path &directory, int depth,
+                                 ScanContext &context,
+                                 StringArena &names,
+                                 std::vector<FileEntry> &batch,
+                                 std::vector<ScanTask> &subdirectories)
+{
+    auto logger = Logger::get_logger("core_logger");
+    const FileScanOptions options = context.options;
+    const NameFilter *filter = context.filter.get();
+    const DirectoryPredicate &is_pruned = context.pruned_directories;
+    const bool descend = has_flag(options, FileScanOptions::Recursive) &&
+                         (context.max_depth <= 0 || depth < context.max_depth);
+
+    const std::string directory_string = directory.string();
+    const bool needs_separator = !directory_string.empty() &&
+        directory_string.back() != static_cast<char>(fs::path::preferred_separator);
+
+    std::optional<PathTable::DirId> dir_id;
+
+    auto visit = [&](const RawEntry &raw) {
+        if (context.cancelled.load(std::memory_order_relaxed)) return;
+        if (is_junk_file(raw.name)) return;
+
+        const bool is_bundle = raw.kind == EntryKind::Directory && is_file_bundle(raw.name);
+        if (filter) {
+            const bool as_file = raw.kind == EntryKind::Regular || is_bundle;
+            if (as_file ? !filter->accepts_file(raw.name) : filter->is_excluded(raw.name)) {
+                return;
             }
-            else if (fs::is_regular_file(entry)) {
-                if (has_flag(options, FileScanOptions::Files) &&
-                    (has_flag(options, FileScanOptions::HiddenFiles) || !is_hidden)) {
-                    file_type = FileType::File;
-                    should_add = true;
-                }
+        }
+
+        const bool visible = has_flag(options, FileScanOptions::HiddenFiles) || !raw.is_hidden;
+        bool should_add = false;
+        FileType file_type;
+
+        if (is_bundle) {
+            if (has_flag(options, FileScanOptions::Files) && visible) {
+                file_type = FileType::File;
+                should_add = true;
+            }
+        }
+        else if (raw.kind == EntryKind::Regular) {
+            if (has_flag(options, FileScanOptions::Files) && visible) {
+                file_type = FileType::File;
+                should_add = true;
+            }
+        }
+        else if (raw.kind == EntryKind::Directory) {
+            if (has_flag(options, FileScanOptions::Directories) && visible) {
+                file_type = FileType::Directory;
+                should_add = true;
             }
-            else if (fs::is_directory(entry)) {
-                if (has_flag(options, FileScanOptions::Directories) &&
-                    (has_flag(options, FileScanOptions::HiddenFiles) || !is_hidden)) {
-                    file_type = FileType::Directory;
-                    should_add = true;
+            // Symlinked directories are not followed to avoid cycles, and a
+            // directory handed over as an entry may be moved as a whole.
+            if (descend && visible && !raw.is_symlink && !should_add) {
+                std::string subdirectory;
+                subdirectory.reserve(directory_string.size() + raw.name.size() + 1);
+                subdirectory.append(directory_string);
+                if (needs_separator) subdirectory.push_back(static_cast<char>(fs::path::preferred_separator));
+                subdirectory.append(raw.name);
+                // Sort output folders only hold files that were already sorted.
+                if (is_pruned && is_pruned(subdirectory)) {
+                    if (logger) {
+                        logger->info("Not scanning '{}': it was created by sorting", subdirectory);
+                    }
+                } else {
+                    subdirectories.push_back({fs::path(std::move(subdirectory)), depth + 1});
                 }
             }
+        }
 
-            if (should_add) {
-                file_paths_and_names.push_back({full_path, file_name, file_type});
-            } else if (logger && is_hidden && !has_flag(options, FileScanOptions::HiddenFiles)) {
-                logger->trace("Skipping hidden entry '{}'", full_path);
+        if (should_add) {
+            if (!dir_id) {
+                dir_id = context.paths->intern_directory(directory_string);
             }
+            batch.push_back({context.paths, *dir_id, names.store(raw.name), file_type});
+            if (batch.size() >= kEntryBatchSize) {
+                context.flush(batch);
+            }
+        } else if (logger && raw.is_hidden && !has_flag(options, FileScanOptions::HiddenFiles)) {
+            logger->trace("Skipping hidden entry '{}' in '{}'", raw.name, directory_string);
         }
-    } catch (const fs::filesystem_error& ex) {
-        if (logger) {
-            logger->warn("Error while scanning '{}': {}", directory_path, ex.what());
-        }
-        throw;
+    };
+
+    DirectoryStamp stamp;
+    if (!context.snapshot || !read_directory_stamp(directory, stamp)) {
+        for_each_entry(directory, visit);
+        return;
     }
 
-    if (logger) {
-        logger->info("Directory scan complete for '{}': {} item(s) queued", directory_path,
-                     file_paths_and_names.size());
+    auto previous = context.snapshot->find(directory_string);
+    if (previous && previous->inode == stamp.inode && previous->mtime_ns == stamp.mtime_ns &&
+        previous->mtime_ns + kSnapshotSettleNs < previous->scanned_at_ns) {
+        // Adding, removing or renaming an entry bumps the directory mtime, so
+        // the remembered listing is still accurate.
+        context.snapshot->mark_visited(directory_string);
+        context.reused_directories.fetch_add(1, std::memory_order_relaxed);
+        for (const auto &entry : previous->entries) {
+            visit(RawEntry{entry.name, entry.kind, entry.is_symlink, entry.is_hidden});
+        }
+        return;
     }
 
-    return file_paths_and_names;
+    DirectorySnapshot fresh{stamp.inode, stamp.mtime_ns, stamp.taken_at_ns, {}};
+    for_each_entry(directory, [&](const RawEntry &raw) {
+        fresh.entries.push_back({std::string(raw.name), raw.kind, raw.is_symlink, raw.is_hidden});
+        visit(raw);
+    });
+    // A listing cut short by cancellation must not replace the stored one.
+    if (!context.cancelled.load(std::memory_order_relaxed)) {
+        context.snapshot->update(directory_string, std::move(fresh));
+    }
 }
 
 
-bool FileScanner::is_file_hidden(const fs::path &path) {
-#ifdef _WIN32
-    DWORD attrs = GetFileAttributesW(path.c_str());
-    return (attrs != INVALID_FILE_ATTRIBUTES) &&
-           (attrs & FILE_ATTRIBUTE_HIDDEN);
-#else
-    return path.filename().string().starts_with(".");
-#endif
+void FileScanner::scan_recursive(std::vector<ScanTask> subdirectories,
+                                 ScanContext &context)
+{
+    auto logger = Logger::get_logger("core_logger");
+    size_t worker_count = thread_count ? thread_count : std::thread::hardware_concurrency();
+    worker_count = std::clamp<size_t>(worker_count, 1, 64);
+
+    WorkStealingQueues<ScanTask> queues(worker_count);
+    for (size_t i = 0; i < subdirectories.size(); ++i) {
+        queues.push(i % worker_count, std::move(subdirectories[i]));
+    }
+
+    auto worker = [&](size_t id) {
+        StringArena &names = context.paths->make_arena();
+        std::vector<FileEntry> batch;
+        std::vector<ScanTask> found;
+        ScanTask task;
+        while (queues.pop(id, task)) {
+            // After cancellation the remaining tasks are only drained.
+            if (!context.cancelled.load(std::memory_order_relaxed)) {
+                found.clear();
+                try {
+                    scan_directory(task.path, task.depth, context, names, batch, found);
+                } catch (const fs::filesystem_error& ex) {
+                    // A single unreadable subdirectory should not abort the whole tree.
+                    if (logger) {
+                        logger->warn("Skipping '{}': {}", task.path.string(), ex.what());
+                    }
+                }
+                context.flush(batch);
+
+                for (auto &subdirectory : found) {
+                    queues.push(id, std::move(subdirectory));
+                }
+            }
+            queues.complete();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(worker_count - 1);
+    for (size_t id = 1; id < worker_count; ++id) {
+        threads.emplace_back(worker, id);
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (logger) {
+        logger->debug("Recursive scan used {} worker thread(s)", worker_count);
+    }
 }
 
 
-bool FileScanner::is_junk_file(const std::string& name) {
-    static const std::unordered_set<std::string> junk = {
+bool FileScanner::is_junk_file(std::string_view name) {
+    static constexpr std::string_view junk[] = {
         ".DS_Store", "Thumbs.db", "desktop.ini"
     };
-    return junk.contains(name);
+    return std::find(std::begin(junk), std::end(junk), name) != std::end(junk);
 }
 
 
-bool FileScanner::is_file_bundle(const fs::path& path) {
+bool FileScanner::is_file_bundle(std::string_view name) {
     static const std::unordered_set<std::string> bundle_extensions = {
         ".app", ".utm", ".vmwarevm", ".pvm", ".vbox", ".pkg", ".mpkg",
         ".prefPane", ".plugin", ".framework", ".kext", ".qlgenerator",
         ".mdimporter", ".wdgt", ".scptd", ".nib", ".xib"
     };
-    if (!fs::is_directory(path)) return false;
 
-    std::string ext = path.extension().string();
+    // Same rule as fs::path::extension(): a leading dot does not start an extension.
+    size_t dot = name.find_last_of('.');
+    if (dot == std::string_view::npos || dot == 0) return false;
+
+    std::string ext(name.substr(dot));
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
     return bundle_extensions.contains(ext);
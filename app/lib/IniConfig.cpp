@@ -70,6 +70,12 @@ void IniConfig::setValue(const std::string &section, const std::string &key, con
 }
 
 
+const std::map<std::string, std::string> *IniConfig::getSection(const std::string &section) const {
+    auto sec_it = data.find(section);
+    return sec_it != data.end() ? &sec_it->second : nullptr;
+}
+
+
 bool IniConfig::save(const std::string &filename) const
 {
     std::ofstream file(filename);
@@ -132,6 +132,7 @@ std::string LLMClient::send_api_request(std::string json_payload) {
 
 std::string LLMClient::categorize_file(const std::string& file_name,
                                        const std::string& file_path,
+                                       const std::string& content_type,
                                        FileType file_type)
 {
     if (auto logger = Logger::get_logger("core_logger")) {
@@ -142,7 +143,7 @@ std::string LLMClient::categorize_file(const std::string& file_name,
             logger->debug("Requesting remote categorization for '{}' ({})", file_name, to_string(file_type));
         }
     }
-    std::string json_payload = make_payload(file_name, file_path, file_type);
+    std::string json_payload = make_payload(file_name, file_path, content_type, file_type);
 
     return send_api_request(json_payload);
 }
@@ -150,6 +151,7 @@ std::string LLMClient::categorize_file(const std::string& file_name,
 
 std::string LLMClient::make_payload(const std::string& file_name,
                                     const std::string& file_path,
+                                    const std::string& content_type,
                                     const FileType file_type)
 {
     std::string prompt;
@@ -163,7 +165,9 @@ std::string LLMClient::make_payload(const std::string& file_name,
     }
 
     if (file_type == FileType::File) {
-        // already set above
+        if (!content_type.empty()) {
+            prompt += "\nDetected content: " + content_type;
+        }
     } else {
         if (!sanitized_path.empty()) {
             prompt = "Categorize the directory with full path: " + sanitized_path + "\nDirectory name: " + file_name;
@@ -178,7 +182,7 @@ std::string LLMClient::make_payload(const std::string& file_name,
     {
         "model": "gpt-4o-mini",
         "messages": [
-            {"role": "system", "content": "You are a file categorization assistant. If it's an installer, describe the type of software it installs. Consider the filename, extension, and any directory context provided. Always reply with one line in the format <Main category> : <Subcategory>. Main category must be broad (one or two words, plural). Subcategory must be specific, relevant, and must not repeat the main category."},
+            {"role": "system", "content": "You are a file categorization assistant. If it's an installer, describe the type of software it installs. Consider the filename, extension, detected content, and any directory context provided. Always reply with one line in the format <Main category> : <Subcategory>. Main category must be broad (one or two words, plural). Subcategory must be specific, relevant, and must not repeat the main category."},
             {"role": "user", "content": ")" + escaped_prompt + R"("}
         ]
     }
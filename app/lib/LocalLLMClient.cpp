@@ -2,16 +2,21 @@
 #include "Logger.hpp"
 #include "Utils.hpp"
 #include "llama.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 #include <cctype>
 #include <cstdio>
 #include <stdexcept>
-#include <regex>
 #include <iostream>
 #include <sstream>
 #include <spdlog/spdlog.h>
 #include <cstdlib>
+#include <mutex>
 
 #if defined(_WIN32)
 static void set_env_var(const char *key, const char *value) {
@@ -24,6 +29,68 @@ static void set_env_var(const char *key, const char *value) {
 #endif
 
 
+namespace {
+
+// Prompts decoded together, each in its own sequence. The instruction
+// prefix they share is stored once, so the context only has to hold the
+// per-item lines and answers of each.
+constexpr size_t kMaxSequences = 8;
+constexpr uint32_t kContextTokens = 2048;
+
+// Exactly one "Category : Subcategory" line, as the instructions ask for.
+// Names are words separated by single spaces; colons, brackets and line
+// breaks cannot occur in them, so every answer splits the same way and
+// generation ends with the line.
+constexpr const char *kAnswerGrammar = R"(
+root ::= name " : " name "\n"
+name ::= word (" " word)*
+word ::= [^ \t\r\n:()]+
+)";
+
+constexpr std::string_view kWhitespace = " \t\n\r\f\v";
+
+// Whether output already holds a whole non-empty line; the answer is
+// complete then and nothing after it would be used.
+bool answer_complete(std::string_view output)
+{
+    const size_t start = output.find_first_not_of(kWhitespace);
+    return start != std::string_view::npos && output.find('\n', start) != std::string_view::npos;
+}
+
+size_t common_prefix_length(const std::vector<llama_token> &a, const std::vector<llama_token> &b)
+{
+    return std::mismatch(a.begin(), a.end(), b.begin(), b.end()).first - a.begin();
+}
+
+// Owns a batch from llama_batch_init.
+class BatchBuffer {
+public:
+    explicit BatchBuffer(int32_t capacity) : batch(llama_batch_init(capacity, 0, 1)) {}
+    ~BatchBuffer() { llama_batch_free(batch); }
+    BatchBuffer(const BatchBuffer &) = delete;
+    BatchBuffer &operator=(const BatchBuffer &) = delete;
+
+    void clear() { batch.n_tokens = 0; }
+    // Returns the token's index in the batch.
+    int32_t add(llama_token token, llama_pos pos, llama_seq_id seq, bool logits) {
+        const int32_t i = batch.n_tokens++;
+        batch.token[i] = token;
+        batch.pos[i] = pos;
+        batch.n_seq_id[i] = 1;
+        batch.seq_id[i][0] = seq;
+        batch.logits[i] = logits;
+        return i;
+    }
+    int32_t size() const { return batch.n_tokens; }
+    const llama_batch &get() const { return batch; }
+
+private:
+    llama_batch batch;
+};
+
+} // namespace
+
+
 void silent_logger(enum ggml_log_level, const char *, void *) {}
 
 
@@ -37,48 +104,30 @@ void llama_debug_logger(enum ggml_log_level level, const char *text, void *user_
 }
 
 
-LocalLLMClient::LocalLLMClient(const std::string& model_path)
-    : model_path(model_path)
-{
-    auto logger = Logger::get_logger("core_logger");
-    if (logger) {
-        logger->info("Initializing local LLM client with model '{}'", model_path);
-    }
+int LocalLLMClient::gpu_layers = 0;
 
-    llama_log_set(silent_logger, nullptr);
 
-    bool cuda_available = false;
+void LocalLLMClient::prepare_environment()
+{
+    static std::once_flag prepared;
+    std::call_once(prepared, [] {
 #ifdef GGML_USE_METAL
-    (void)cuda_available;
+        gpu_layers = 0;
 #else
-    cuda_available = Utils::is_cuda_available();
-    if (!cuda_available) {
-        set_env_var("GGML_DISABLE_CUDA", "1");
-    }
-#endif
-
-    ggml_backend_load_all();
-
-
-    llama_model_params model_params = llama_model_default_params();
-
-    #ifdef GGML_USE_METAL
-        model_params.n_gpu_layers = 0;
-    #else
-        if (cuda_available) {
+        if (Utils::is_cuda_available()) {
             int ngl = Utils::determine_ngl_cuda();
             if (ngl > 0) {
-                model_params.n_gpu_layers = ngl;
-                std::cout << "ngl: " << model_params.n_gpu_layers << std::endl;
+                gpu_layers = ngl;
+                std::cout << "ngl: " << gpu_layers << std::endl;
             } else {
-                model_params.n_gpu_layers = 0;
+                gpu_layers = 0;
                 set_env_var("GGML_DISABLE_CUDA", "1");
                 std::cout << "CUDA not usable, falling back to CPU.\n";
             }
         } else {
-            model_params.n_gpu_layers = 0;
-            printf("model_params.n_gpu_layers: %d\n",
-                model_params.n_gpu_layers);
+            gpu_layers = 0;
+            set_env_var("GGML_DISABLE_CUDA", "1");
+            printf("model_params.n_gpu_layers: %d\n", gpu_layers);
             std::vector<std::string> devices;
             if (Utils::is_opencl_available(&devices)) {
                 std::cout << "OpenCL is available.\n";
@@ -88,7 +137,28 @@ LocalLLMClient::LocalLLMClient(const std::string& model_path)
                 std::cout << "OpenCL not found.\n";
             }
         }
-    #endif
+#endif
+    });
+}
+
+
+LocalLLMClient::LocalLLMClient(const std::string& model_path, bool persist_prompt_cache)
+    : model_path(model_path),
+      prompt_cache_path(persist_prompt_cache ? model_path + ".prompt-cache" : "")
+{
+    auto logger = Logger::get_logger("core_logger");
+    if (logger) {
+        logger->info("Initializing local LLM client with model '{}'", model_path);
+    }
+
+    llama_log_set(silent_logger, nullptr);
+
+    // A no-op when the main thread already did it, as it should have.
+    prepare_environment();
+    ggml_backend_load_all();
+
+    llama_model_params model_params = llama_model_default_params();
+    model_params.n_gpu_layers = gpu_layers;
 
     model = llama_model_load_from_file(model_path.c_str(), model_params);
     if (!model) {
@@ -105,14 +175,54 @@ LocalLLMClient::LocalLLMClient(const std::string& model_path)
     vocab = llama_model_get_vocab(model);
 
     ctx_params = llama_context_default_params();
-    int n_ctx = 1024;
-    ctx_params.n_ctx = n_ctx;
-    ctx_params.n_batch = n_ctx;
+    ctx_params.n_ctx = kContextTokens;
+    ctx_params.n_batch = kContextTokens;
+    ctx_params.n_seq_max = kMaxSequences;
+    // One cache for all sequences, so a prefix copied between them is
+    // shared rather than duplicated.
+    ctx_params.kv_unified = true;
+
+    // The context and its KV cache are allocated once and cleared between
+    // requests; creating them per file cost more than a short generation.
+    ctx = llama_init_from_model(model, ctx_params);
+    if (!ctx) {
+        if (logger) {
+            logger->error("Failed to initialize llama context for '{}'", model_path);
+        }
+        llama_model_free(model);
+        throw std::runtime_error("Failed to initialize llama context");
+    }
+
+    // Nothing frees the model and context if the constructor throws past
+    // this point, as the destructor does not run then.
+    try {
+        samplers.reserve(kMaxSequences);
+        smpl = llama_sampler_chain_init(llama_sampler_chain_default_params());
+        samplers.push_back(smpl);
+        if (llama_sampler *grammar = llama_sampler_init_grammar(vocab, kAnswerGrammar, "root")) {
+            llama_sampler_chain_add(smpl, grammar);
+        } else if (logger) {
+            logger->warn("Could not build the answer grammar; sampling without it");
+        }
+        llama_sampler_chain_add(smpl, llama_sampler_init_min_p(0.05f, 1));
+        llama_sampler_chain_add(smpl, llama_sampler_init_temp(0.8f));
+        llama_sampler_chain_add(smpl, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
+        // Every sequence of a batch samples with its own copy of the chain.
+        while (samplers.size() < kMaxSequences) {
+            samplers.push_back(llama_sampler_clone(smpl));
+        }
+
+        warm_up_prompt_cache();
+    } catch (...) {
+        release();
+        throw;
+    }
 }
 
 
 std::string LocalLLMClient::make_prompt(const std::string& file_name,
                                         const std::string& file_path,
+                                        const std::string& content_type,
                                         FileType file_type)
 {
     std::ostringstream user_section;
@@ -120,13 +230,16 @@ std::string LocalLLMClient::make_prompt(const std::string& file_name,
         user_section << "\nFull path: " << file_path << "\n";
     }
     user_section << "Name: " << file_name << "\n";
+    if (!content_type.empty()) {
+        user_section << "Detected content: " << content_type << "\n";
+    }
 
     std::string prompt = (file_type == FileType::File)
         ? "\nCategorize this file:\n" + user_section.str()
         : "\nCategorize the directory:\n" + user_section.str();
 
     std::string instruction = R"(<|begin_of_text|><|start_header_id|>system<|end_header_id|>
-    You are a file categorization assistant. You must always follow the exact format. If the file is an installer, determine the type of software it installs. Base your answer on the filename, extension, and any directory context provided. The output must be:
+    You are a file categorization assistant. You must always follow the exact format. If the file is an installer, determine the type of software it installs. Base your answer on the filename, extension, detected content, and any directory context provided. The output must be:
     <Main category> : <Subcategory>
     Main category must be broad (one or two words, plural). Subcategory must be specific, relevant, and never just repeat the main category. Output exactly one line. Do not explain, add line breaks, or use words like 'Subcategory'. If uncertain, always make your best guess based on the name only. Do not apologize or state uncertainty. Never say you lack information.
     Examples:
@@ -141,26 +254,9 @@ std::string LocalLLMClient::make_prompt(const std::string& file_name,
 }
 
 
-std::string LocalLLMClient::generate_response(const std::string &prompt,
-                                              int n_predict)
+std::vector<llama_token> LocalLLMClient::tokenize_prompt(const std::string &prompt)
 {
     auto logger = Logger::get_logger("core_logger");
-    if (logger) {
-        logger->debug("Generating response with prompt length {} tokens target {}", prompt.size(), n_predict);
-    }
-
-    auto* ctx = llama_init_from_model(model, ctx_params);
-    if (!ctx) {
-        if (logger) {
-            logger->error("Failed to initialize llama context");
-        }
-        return "";
-    }
-
-    auto* smpl = llama_sampler_chain_init(llama_sampler_chain_default_params());
-    llama_sampler_chain_add(smpl, llama_sampler_init_min_p(0.05f, 1));
-    llama_sampler_chain_add(smpl, llama_sampler_init_temp(0.8f));
-    llama_sampler_chain_add(smpl, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
 
     std::vector<llama_chat_message> messages;
     messages.push_back({"user", prompt.c_str()});
@@ -176,7 +272,7 @@ std::string LocalLLMClient::generate_response(const std::string &prompt,
             logger->error("Failed to apply chat template to prompt");
         }
         fprintf(stderr, "Failed to apply chat template\n");
-        return "";
+        return {};
     }
     std::string final_prompt(formatted_prompt.data(), actual_len);
 
@@ -192,61 +288,319 @@ std::string LocalLLMClient::generate_response(const std::string &prompt,
         if (logger) {
             logger->error("Tokenization failed for prompt");
         }
-        llama_model_free(model);
-        return "";
+        return {};
     }
+    return prompt_tokens;
+}
 
-    llama_batch batch = llama_batch_get_one(prompt_tokens.data(),
-                                            prompt_tokens.size());
-    llama_token new_token_id;
-    std::string output;
 
-    const int max_tokens = n_predict;
-    int generated_tokens = 0;
-    for (int n_pos = 0; generated_tokens < max_tokens; ) {
+bool LocalLLMClient::decode_tokens(const llama_token *tokens, size_t count)
+{
+    // Positions continue after whatever the context already holds.
+    const size_t n_batch = ctx_params.n_batch;
+    for (size_t start = 0; start < count; start += n_batch) {
+        const size_t n = std::min(n_batch, count - start);
+        llama_batch batch = llama_batch_get_one(const_cast<llama_token *>(tokens + start),
+                                                static_cast<int32_t>(n));
         if (llama_decode(ctx, batch)) {
+            // The context may hold part of the batch; start over next time.
+            llama_memory_clear(llama_get_memory(ctx), true);
+            cached_tokens.clear();
+            return false;
+        }
+        cached_tokens.insert(cached_tokens.end(), tokens + start, tokens + start + n);
+    }
+    return true;
+}
+
+
+void LocalLLMClient::warm_up_prompt_cache()
+{
+    auto logger = Logger::get_logger("core_logger");
+
+    // The fixed part of the prompt is whatever prompts for different items
+    // have in common: the chat template header, the instructions and the
+    // examples.
+    std::vector<llama_token> prefix = tokenize_prompt(make_prompt("a.txt", "", "", FileType::File));
+    const std::vector<llama_token> other = tokenize_prompt(make_prompt("b", "", "", FileType::Directory));
+    const size_t n_prefix = std::mismatch(prefix.begin(), prefix.end(), other.begin(), other.end()).first -
+                            prefix.begin();
+    prefix.resize(n_prefix);
+    if (prefix.empty()) {
+        return;
+    }
+
+    if (!prompt_cache_path.empty() && load_prompt_cache(prefix)) {
+        if (logger) {
+            logger->info("Loaded {} prompt prefix token(s) from '{}'", prefix.size(), prompt_cache_path);
+        }
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!decode_tokens(prefix.data(), prefix.size())) {
+        if (logger) {
+            logger->warn("Failed to decode the prompt prefix; every request will decode it");
+        }
+        return;
+    }
+    if (logger) {
+        logger->info("Decoded {} prompt prefix token(s) in {} ms", prefix.size(),
+                     std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start).count());
+    }
+
+    if (!prompt_cache_path.empty()) {
+        // Written under another name first so a reader never sees half a file.
+        const std::string temp_path = prompt_cache_path + ".tmp";
+        std::error_code ec;
+        if (llama_state_save_file(ctx, temp_path.c_str(), prefix.data(), prefix.size())) {
+            std::filesystem::rename(temp_path, prompt_cache_path, ec);
+        } else {
+            ec = std::make_error_code(std::errc::io_error);
+        }
+        if (ec) {
+            std::filesystem::remove(temp_path, ec);
             if (logger) {
-                logger->warn("llama_decode returned non-zero status; aborting generation");
+                logger->warn("Failed to save the prompt cache to '{}'", prompt_cache_path);
             }
-            break;
         }
+    }
+}
+
+
+bool LocalLLMClient::load_prompt_cache(const std::vector<llama_token> &prefix)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(prompt_cache_path, ec)) {
+        return false;
+    }
+
+    std::vector<llama_token> stored(ctx_params.n_ctx);
+    size_t n_stored = 0;
+    if (llama_state_load_file(ctx, prompt_cache_path.c_str(), stored.data(), stored.size(), &n_stored)) {
+        stored.resize(n_stored);
+        // A file written for another prompt or template is decoded afresh
+        // and replaced.
+        if (stored == prefix) {
+            cached_tokens = std::move(stored);
+            return true;
+        }
+    }
+    if (auto logger = Logger::get_logger("core_logger")) {
+        logger->info("Prompt cache '{}' does not match the current prompt; rebuilding it",
+                     prompt_cache_path);
+    }
+    llama_memory_clear(llama_get_memory(ctx), true);
+    cached_tokens.clear();
+    return false;
+}
+
 
-        n_pos += batch.n_tokens;
-        new_token_id = llama_sampler_sample(smpl, ctx, -1);
+std::string LocalLLMClient::generate_response(const std::string &prompt,
+                                              int n_predict)
+{
+    return generate_responses({prompt}, n_predict).front();
+}
+
+
+std::vector<std::string> LocalLLMClient::generate_responses(const std::vector<std::string> &prompts,
+                                                            int n_predict)
+{
+    auto logger = Logger::get_logger("core_logger");
+    if (logger) {
+        logger->debug("Generating responses for {} prompt(s), target {} token(s) each",
+                      prompts.size(), n_predict);
+    }
+
+    // A request abandoned after a timeout may still be generating.
+    std::lock_guard<std::mutex> lock(generation_mutex);
+
+    std::vector<std::string> outputs(prompts.size());
+    std::vector<std::vector<llama_token>> tokens;
+    tokens.reserve(prompts.size());
+    std::vector<size_t> order;
+    for (size_t i = 0; i < prompts.size(); ++i) {
+        tokens.push_back(tokenize_prompt(prompts[i]));
+        if (!tokens.back().empty()) {
+            order.push_back(i);
+        }
+    }
+
+    // Consecutive prompts form a group while there are sequences left and
+    // the context can hold their shared prefix once plus everything else.
+    const size_t n_ctx = ctx_params.n_ctx;
+    const size_t n_answer = static_cast<size_t>(std::max(n_predict, 0));
+    for (size_t start = 0; start < order.size(); ) {
+        std::vector<size_t> group{order[start]};
+        const std::vector<llama_token> &first = tokens[order[start]];
+        size_t n_common = first.size() - 1;
+        size_t n_total = first.size();
+        for (size_t k = start + 1; k < order.size() && group.size() < kMaxSequences; ++k) {
+            const std::vector<llama_token> &next = tokens[order[k]];
+            const size_t common = std::min({common_prefix_length(first, next), n_common, next.size() - 1});
+            const size_t count = group.size() + 1;
+            if (n_total + next.size() - (count - 1) * common + count * n_answer > n_ctx) {
+                break;
+            }
+            group.push_back(order[k]);
+            n_common = common;
+            n_total += next.size();
+        }
+        start += group.size();
+
+        if (!generate_group(group, tokens, n_common, n_predict, outputs) && logger) {
+            logger->warn("llama_decode returned non-zero status; aborting generation of {} response(s)",
+                         group.size());
+        }
+    }
+
+    for (auto &output : outputs) {
+        if (logger) {
+            logger->debug("Generation complete, produced {} character(s)", output.size());
+        }
+        sanitize_output(output);
+    }
+    return outputs;
+}
 
-        if (llama_vocab_is_eog(vocab, new_token_id)) {
+
+bool LocalLLMClient::generate_group(const std::vector<size_t> &group,
+                                    const std::vector<std::vector<llama_token>> &tokens,
+                                    size_t n_common, int n_predict,
+                                    std::vector<std::string> &outputs)
+{
+    auto logger = Logger::get_logger("core_logger");
+    llama_memory_t memory = llama_get_memory(ctx);
+    const std::vector<llama_token> &first = tokens[group.front()];
+
+    // Sequence 0 keeps what it shares with the group's common prefix (at
+    // least the fixed instructions) and decodes the rest of that prefix; the
+    // other sequences then share its cells. On its own, a prompt simply
+    // continues from whatever it has in common with the context.
+    size_t n_reuse = std::min(common_prefix_length(cached_tokens, first), n_common);
+    if (!llama_memory_seq_rm(memory, 0, static_cast<llama_pos>(n_reuse), -1)) {
+        // Some memory types cannot drop a partial sequence.
+        llama_memory_clear(memory, true);
+        n_reuse = 0;
+    }
+    cached_tokens.resize(n_reuse);
+    if (group.size() == 1) {
+        n_common = n_reuse;
+    } else if (!decode_tokens(first.data() + n_reuse, n_common - n_reuse)) {
+        return false;
+    }
+    for (size_t seq = 1; seq < group.size(); ++seq) {
+        llama_memory_seq_cp(memory, 0, static_cast<llama_seq_id>(seq), -1, -1);
+    }
+    if (logger) {
+        logger->debug("Reusing {} and sharing {} prompt token(s) across {} sequence(s)",
+                      n_reuse, n_common, group.size());
+    }
+
+    struct Sequence {
+        llama_pos n_pos;
+        int32_t logits_index;
+        int generated;
+        bool done;
+    };
+    std::vector<Sequence> sequences(group.size());
+
+    int32_t capacity = 0;
+    for (size_t index : group) {
+        capacity += static_cast<int32_t>(tokens[index].size() - n_common);
+    }
+    BatchBuffer batch(std::max<int32_t>(capacity, static_cast<int32_t>(group.size())));
+    for (size_t seq = 0; seq < group.size(); ++seq) {
+        const std::vector<llama_token> &prompt = tokens[group[seq]];
+        for (size_t pos = n_common; pos < prompt.size(); ++pos) {
+            sequences[seq].logits_index = batch.add(prompt[pos], static_cast<llama_pos>(pos),
+                                                    static_cast<llama_seq_id>(seq),
+                                                    pos + 1 == prompt.size());
+        }
+        sequences[seq].n_pos = static_cast<llama_pos>(prompt.size());
+        sequences[seq].generated = 0;
+        sequences[seq].done = n_predict <= 0;
+        llama_sampler_reset(samplers[seq]);
+    }
+    cached_tokens.insert(cached_tokens.end(), first.begin() + n_common, first.end());
+
+    // Each step decodes the newest token of every unfinished sequence in
+    // one batch.
+    bool ok = true;
+    while (batch.size() > 0) {
+        if (llama_decode(ctx, batch.get())) {
+            llama_memory_clear(memory, true);
+            cached_tokens.clear();
+            ok = false;
             break;
         }
+        batch.clear();
+
+        for (size_t seq = 0; seq < group.size(); ++seq) {
+            Sequence &sequence = sequences[seq];
+            if (sequence.done) continue;
+
+            llama_token new_token_id = llama_sampler_sample(samplers[seq], ctx, sequence.logits_index);
+            if (llama_vocab_is_eog(vocab, new_token_id)) {
+                sequence.done = true;
+                continue;
+            }
 
-        if (n_pos >= n_prompt) {
             char buf[128];
             int n = llama_token_to_piece(vocab, new_token_id, buf,
                                          sizeof(buf), 0, true);
-            if (n < 0) break;
+            if (n < 0) {
+                sequence.done = true;
+                continue;
+            }
+            std::string &output = outputs[group[seq]];
             output.append(buf, n);
-            generated_tokens++;
-        }
+            if (++sequence.generated >= n_predict || answer_complete(output)) {
+                sequence.done = true;
+                continue;
+            }
 
-        batch = llama_batch_get_one(&new_token_id, 1);
+            sequence.logits_index = batch.add(new_token_id, sequence.n_pos++,
+                                              static_cast<llama_seq_id>(seq), true);
+            if (seq == 0) {
+                cached_tokens.push_back(new_token_id);
+            }
+        }
     }
 
-    while (!output.empty() && std::isspace(output.front())) {
-        output.erase(output.begin());
+    // Only sequence 0 is kept for the next request to build on.
+    for (size_t seq = 1; seq < group.size(); ++seq) {
+        llama_memory_seq_rm(memory, static_cast<llama_seq_id>(seq), -1, -1);
     }
+    return ok;
+}
 
-    llama_sampler_reset(smpl);
-    llama_free(ctx);
 
-    if (logger) {
-        logger->debug("Generation complete, produced {} character(s)", output.size());
+std::vector<std::string> LocalLLMClient::categorize_batch(const std::vector<LLMRequest> &requests)
+{
+    std::vector<std::string> prompts;
+    prompts.reserve(requests.size());
+    for (const auto &request : requests) {
+        prompts.push_back(make_prompt(request.file_name, request.file_path,
+                                      request.content_type, request.file_type));
+    }
+    if (auto logger = Logger::get_logger("core_logger")) {
+        logger->debug("Requesting local categorization for {} item(s)", requests.size());
     }
+    return generate_responses(prompts, 64);
+}
+
 
-    return sanitize_output(output);
+size_t LocalLLMClient::max_batch_size() const
+{
+    return kMaxSequences;
 }
 
 
 std::string LocalLLMClient::categorize_file(const std::string& file_name,
                                             const std::string& file_path,
+                                            const std::string& content_type,
                                             FileType file_type)
 {
     if (auto logger = Logger::get_logger("core_logger")) {
@@ -257,33 +611,42 @@ std::string LocalLLMClient::categorize_file(const std::string& file_name,
             logger->debug("Requesting local categorization for '{}' ({})", file_name, to_string(file_type));
         }
     }
-    std::string prompt = make_prompt(file_name, file_path, file_type);
+    std::string prompt = make_prompt(file_name, file_path, content_type, file_type);
     return generate_response(prompt, 64);
 }
 
 
-std::string LocalLLMClient::sanitize_output(std::string& output) {
-    output.erase(0, output.find_first_not_of(" \t\n\r\f\v"));
-    output.erase(output.find_last_not_of(" \t\n\r\f\v") + 1);
-
-    std::regex pattern(R"(([^:\s][^\n:]*?\s*:\s*[^\n]+))");
-    std::smatch match;
-    if (std::regex_search(output, match, pattern)) {
-    std::string result = match[1];
-
-    result.erase(0, result.find_first_not_of(" \t\n\r\f\v"));
-    result.erase(result.find_last_not_of(" \t\n\r\f\v") + 1);
-
-    size_t paren_pos = result.find(" (");
-    if (paren_pos != std::string::npos) {
-        result.erase(paren_pos);
-        result.erase(result.find_last_not_of(" \t\n\r\f\v") + 1);
+void LocalLLMClient::sanitize_output(std::string& output) {
+    // Keeps the first "Category : Subcategory" line, trimmed and without a
+    // trailing remark in brackets. The grammar makes it the only line; this
+    // also copes with output sampled without one. Works in place.
+    const std::string_view text(output);
+    size_t line_start = 0;
+    while (line_start < text.size()) {
+        size_t line_end = text.find('\n', line_start);
+        if (line_end == std::string_view::npos) line_end = text.size();
+        const std::string_view line = text.substr(line_start, line_end - line_start);
+        line_start = line_end + 1;
+
+        const size_t begin = line.find_first_not_of(": \t\r\f\v");
+        if (begin == std::string_view::npos) continue;
+        const size_t colon = line.find(':', begin);
+        if (colon == std::string_view::npos) continue;
+        size_t end = line.find_last_not_of(kWhitespace) + 1;
+        if (end <= colon + 1) continue;
+
+        const size_t paren = line.find(" (", begin);
+        if (paren < end) {
+            end = line.find_last_not_of(kWhitespace, paren) + 1;
+        }
+        const size_t offset = line.data() - text.data();
+        output.erase(offset + end);
+        output.erase(0, offset + begin);
+        return;
     }
 
-    return result;
-}
-
-    return output;
+    output.erase(0, output.find_first_not_of(kWhitespace));
+    output.erase(output.find_last_not_of(kWhitespace) + 1);
 }
 
 
@@ -291,5 +654,23 @@ LocalLLMClient::~LocalLLMClient() {
     if (auto logger = Logger::get_logger("core_logger")) {
         logger->debug("Destroying LocalLLMClient for model '{}'", model_path);
     }
-    if (model) llama_model_free(model);
+    release();
+}
+
+
+void LocalLLMClient::release()
+{
+    for (llama_sampler *sampler : samplers) {
+        llama_sampler_free(sampler);
+    }
+    samplers.clear();
+    smpl = nullptr;
+    if (ctx) {
+        llama_free(ctx);
+        ctx = nullptr;
+    }
+    if (model) {
+        llama_model_free(model);
+        model = nullptr;
+    }
 }
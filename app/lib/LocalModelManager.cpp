@@ -0,0 +1,227 @@
+#include "LocalModelManager.hpp"
+#include "LocalLLMClient.hpp"
+#include "Logger.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/fmt.h>
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+namespace {
+
+// How often an unused model is checked for idleness and memory pressure.
+constexpr std::chrono::seconds kCheckInterval{30};
+// Below this much available memory an unused model is released.
+constexpr std::uint64_t kLowMemoryBytes = 512ull * 1024 * 1024;
+
+template <typename... Args>
+void manager_log(spdlog::level::level_enum level, const char* fmt, Args&&... args) {
+    auto message = fmt::format(fmt::runtime(fmt), std::forward<Args>(args)...);
+    if (auto logger = Logger::get_logger("core_logger")) {
+        logger->log(level, "{}", message);
+    } else {
+        std::fprintf(stderr, "%s\n", message.c_str());
+    }
+}
+
+// Physical memory the system can still hand out, where it can be queried.
+std::optional<std::uint64_t> available_memory()
+{
+#ifdef _WIN32
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        return status.ullAvailPhys;
+    }
+#elif defined(__linux__)
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    std::uint64_t kilobytes = 0;
+    std::string unit;
+    while (meminfo >> key >> kilobytes >> unit) {
+        if (key == "MemAvailable:") {
+            return kilobytes * 1024;
+        }
+    }
+#endif
+    return std::nullopt;
+}
+
+} // namespace
+
+
+struct LocalModelManager::Resident {
+    std::string model_path;
+    std::shared_ptr<LocalLLMClient> client;
+    size_t handles{0};
+    std::chrono::steady_clock::time_point last_used{std::chrono::steady_clock::now()};
+};
+
+
+LocalModelManager::LocalModelManager()
+    : worker(&LocalModelManager::run, this)
+{
+}
+
+
+LocalModelManager::~LocalModelManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+
+    // Releasing a handle reports back to the manager.
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return outstanding_handles == 0; });
+}
+
+
+std::shared_ptr<LocalLLMClient> LocalModelManager::acquire(const std::string &model_path,
+                                                           bool persist_prompt_cache)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return !loading; });
+    if (resident && resident->model_path == model_path) {
+        manager_log(spdlog::level::debug, "Reusing resident local model '{}'", model_path);
+        return make_handle(resident);
+    }
+    return load(lock, model_path, persist_prompt_cache);
+}
+
+
+void LocalModelManager::preload(const std::string &model_path, bool persist_prompt_cache)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        preload_request = PreloadRequest{model_path, persist_prompt_cache};
+    }
+    changed.notify_all();
+}
+
+
+void LocalModelManager::set_idle_timeout(std::chrono::minutes timeout)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle_timeout = timeout;
+    }
+    changed.notify_all();
+}
+
+
+std::shared_ptr<LocalLLMClient> LocalModelManager::load(std::unique_lock<std::mutex> &lock,
+                                                        const std::string &model_path,
+                                                        bool persist_prompt_cache)
+{
+    loading = true;
+    // A model nobody uses any more is released before its replacement is
+    // loaded, so the two are not in memory together.
+    if (resident && resident->handles == 0) {
+        unload(lock, "another model was requested");
+    }
+
+    lock.unlock();
+    std::shared_ptr<LocalLLMClient> client;
+    try {
+        const auto start = std::chrono::steady_clock::now();
+        client = std::make_shared<LocalLLMClient>(model_path, persist_prompt_cache);
+        manager_log(spdlog::level::info, "Local model '{}' loaded in {} ms", model_path,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - start).count());
+    } catch (...) {
+        lock.lock();
+        loading = false;
+        changed.notify_all();
+        throw;
+    }
+    lock.lock();
+    loading = false;
+    changed.notify_all();
+
+    auto loaded = std::make_shared<Resident>();
+    loaded->model_path = model_path;
+    loaded->client = std::move(client);
+    resident = loaded;
+    return make_handle(loaded);
+}
+
+
+std::shared_ptr<LocalLLMClient> LocalModelManager::make_handle(const std::shared_ptr<Resident> &owner)
+{
+    ++owner->handles;
+    ++outstanding_handles;
+    // The handle shares the client but reports back when it is dropped, so
+    // the idle time counts from the last release.
+    return std::shared_ptr<LocalLLMClient>(owner->client.get(), [this, owner](LocalLLMClient *) {
+        // Notified under the lock: the destructor may be waiting for this
+        // handle and must not return before the manager is left alone.
+        std::lock_guard<std::mutex> lock(mutex);
+        --owner->handles;
+        --outstanding_handles;
+        owner->last_used = std::chrono::steady_clock::now();
+        changed.notify_all();
+    });
+}
+
+
+void LocalModelManager::unload(std::unique_lock<std::mutex> &lock, const char *reason)
+{
+    std::shared_ptr<Resident> released = std::move(resident);
+    manager_log(spdlog::level::info, "Unloading local model '{}': {}", released->model_path, reason);
+    // Freeing the model can take a while; acquire() may proceed meanwhile.
+    lock.unlock();
+    released.reset();
+    lock.lock();
+}
+
+
+void LocalModelManager::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (preload_request) {
+            PreloadRequest request = std::move(*preload_request);
+            preload_request.reset();
+            if (!loading && !(resident && resident->model_path == request.model_path)) {
+                manager_log(spdlog::level::info, "Preloading local model '{}'", request.model_path);
+                try {
+                    // The model stays resident once the handle is dropped;
+                    // dropping it takes the lock.
+                    auto handle = load(lock, request.model_path, request.persist_prompt_cache);
+                    lock.unlock();
+                    handle.reset();
+                    lock.lock();
+                } catch (const std::exception &ex) {
+                    manager_log(spdlog::level::warn, "Preloading '{}' failed: {}",
+                                request.model_path, ex.what());
+                }
+            }
+            continue;
+        }
+
+        if (resident && resident->handles == 0) {
+            const auto idle = std::chrono::steady_clock::now() - resident->last_used;
+            if (idle_timeout.count() > 0 && idle >= idle_timeout) {
+                unload(lock, "idle timeout");
+                continue;
+            }
+            if (auto available = available_memory(); available && *available < kLowMemoryBytes) {
+                unload(lock, fmt::format("{} MiB of memory available",
+                                         *available / (1024 * 1024)).c_str());
+                continue;
+            }
+        }
+
+        changed.wait_for(lock, kCheckInterval);
+    }
+}
@@ -1,5 +1,7 @@
 #include "MainApp.hpp"
+#include "BoundedQueue.hpp"
 #include "CategorizationSession.hpp"
+#include "ContentSniffer.hpp"
 #include "CryptoManager.hpp"
 #include "DialogUtils.hpp"
 #include "ErrorMessages.hpp"
@@ -9,11 +11,15 @@
 #include "Logger.hpp"
 #include "MainAppEditActions.hpp"
 #include "MainAppHelpActions.hpp"
+#include "ScanSnapshot.hpp"
 #include "Updater.hpp"
 #include "Utils.hpp"
 #include "Types.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <filesystem>
 #include <future>
 #include <iostream>
@@ -31,7 +37,7 @@
 #include <string>
 #include <sstream>
 #include <thread>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 #include <fmt/format.h>
 #include <LocalLLMClient.hpp>
@@ -43,6 +49,7 @@ MainApp::MainApp(int argc, char **argv, Settings& settings)
     : builder(nullptr),
       settings(settings),
       db_manager(settings.get_config_dir()),
+      categorization_rules(settings.get_config_dir()),
       categorization_dialog(nullptr),
       use_subcategories_checkbox(nullptr), 
       categorize_files_checkbox(nullptr), 
@@ -55,6 +62,19 @@ MainApp::MainApp(int argc, char **argv, Settings& settings)
         using_local_llm = true;
     }
 
+    model_manager.set_idle_timeout(std::chrono::minutes(std::max(settings.get_local_model_idle_minutes(), 0)));
+
+    name_filter = std::make_shared<const NameFilter>(settings.get_exclude_patterns(),
+                                                     settings.get_include_patterns());
+    dirscanner.set_name_filter(name_filter);
+    // Sorting moves files into category folders next to them; a recursive
+    // scan would otherwise find them there again under new paths.
+    auto is_sort_destination = [this](const std::string& path) {
+        return db_manager.is_sort_destination(path);
+    };
+    dirscanner.set_pruned_directories(is_sort_destination);
+    directory_watcher.set_pruned_directories(is_sort_destination);
+
     stop_analysis = false;
 
     gtk_app = create_app();
@@ -210,14 +230,25 @@ void MainApp::update_checkbox_settings(GtkCheckButton* checkbox)
 }
 
 
-std::unordered_set<std::string> MainApp::extract_file_names(
+std::unordered_map<std::string, size_t> MainApp::index_categorized_files(
     const std::vector<CategorizedFile>& categorized_files)
 {
-    std::unordered_set<std::string> file_names;
-    for (const auto& [file_path, file_name, file_type, category, subcategory, taxonomy_id] : categorized_files) {
-        file_names.insert(file_name);
+    std::unordered_map<std::string, size_t> index;
+    index.reserve(categorized_files.size());
+    for (size_t i = 0; i < categorized_files.size(); ++i) {
+        const auto& file = categorized_files[i];
+        index.emplace((std::filesystem::path(file.file_path) / file.file_name).string(), i);
+    }
+    return index;
+}
+
+
+FileScanOptions MainApp::current_scan_options() const
+{
+    if (settings.get_recursive_scan()) {
+        return file_scan_options | FileScanOptions::Recursive;
     }
-    return file_names;
+    return file_scan_options;
 }
 
 
@@ -275,7 +306,10 @@ void MainApp::perform_analysis()
     }
 
     try {
-        already_categorized_files = db_manager.get_categorized_files(directory_path);
+        // Results confirmed in an earlier dialog may still be queued.
+        db_manager.flush_writes();
+        already_categorized_files = db_manager.get_categorized_files(
+            directory_path, settings.get_recursive_scan());
 
         if (!already_categorized_files.empty()) {
             g_idle_add([](gpointer user_data) -> gboolean {
@@ -304,70 +338,22 @@ void MainApp::perform_analysis()
             }, context.release());
         }
 
-        std::unordered_set<std::string> cached_file_names = extract_file_names(already_categorized_files);
-        
-        if (stop_analysis) {
-            return;
-        }
-
-        files_to_categorize = find_files_to_categorize(directory_path, cached_file_names);
-        core_logger->debug("Found {} item(s) pending categorization in '{}'.",
-                           files_to_categorize.size(), directory_path);
-
-        if (!files_to_categorize.empty()) {
-            g_idle_add([](gpointer user_data) -> gboolean {
-                MainApp* app = static_cast<MainApp*>(user_data);
-                app->progress_dialog->append_text("[QUEUE] Items waiting for categorization:");
-                return G_SOURCE_REMOVE;
-            }, this);
-        } else {
-            g_idle_add([](gpointer user_data) -> gboolean {
-                MainApp* app = static_cast<MainApp*>(user_data);
-                app->progress_dialog->append_text("[DONE] No files to categorize.");
-                return G_SOURCE_REMOVE;
-            }, this);
-        }
-
-        for (const auto& file_entry : files_to_categorize) {
-            auto* context = new AnalysisContext(
-                                                this,
-                                                file_entry.file_name,
-                                                file_entry.type,
-                                                "",  // No category
-                                                ""   // No subcategory
-                                                );
-
-            g_idle_add([](gpointer user_data) -> gboolean {
-                auto* ctx = static_cast<AnalysisContext*>(user_data);
-                const char* symbol = ctx->file_type == FileType::Directory ? "DIR" : "FILE";
-                ctx->app->progress_dialog->append_text(
-                    fmt::format("  - [{}] {}", symbol, ctx->file_name));
-                delete ctx;
-                return G_SOURCE_REMOVE;
-            }, context);
-        }
-
         if (stop_analysis) {
             return;
         }
 
-        g_idle_add([](gpointer user_data) -> gboolean {
-            MainApp* app = static_cast<MainApp*>(user_data);
-            app->progress_dialog->append_text("[PROCESS] Letting the AI do its magic...");
-            return G_SOURCE_REMOVE;
-        }, this);
-
-        this->new_files_with_categories = categorize_files(files_to_categorize);
+        this->new_files_with_categories.clear();
+        this->new_files_to_sort = categorize_streamed_files(directory_path);
         core_logger->info("Categorization produced {} new record(s).",
                           new_files_with_categories.size());
 
         this->already_categorized_files.insert(
             already_categorized_files.end(),
-            new_files_with_categories.begin(),
-            new_files_with_categories.end()
+            std::make_move_iterator(new_files_with_categories.begin()),
+            std::make_move_iterator(new_files_with_categories.end())
         );
+        this->new_files_with_categories.clear();
 
-        this->new_files_to_sort = compute_files_to_sort();
         core_logger->debug("{} file(s) queued for sorting after analysis.",
                            new_files_to_sort.size());
 
@@ -383,7 +369,7 @@ void MainApp::perform_analysis()
             return app->update_ui_after_analysis();
         }, this);
     } catch (const std::exception& ex) {
-        DialogUtils::show_error_dialog(GTK_WINDOW(this->main_window), "Analysis Error: " + std::string(ex.what()));
+        show_error_dialog("Analysis Error: " + std::string(ex.what()));
         core_logger->error("Exception during analysis: {}", ex.what());
     }
 }
@@ -399,8 +385,8 @@ MainApp::get_actual_files(const std::string& directory_path)
     
     core_logger->info("Actual files found: {}", static_cast<int>(actual_files.size()));
 
-    for (const auto& [full_file_path, file_name, file_type] : actual_files) {
-        core_logger->info("File: {}, Path: {}", file_name, full_file_path);
+    for (const auto& entry : actual_files) {
+        core_logger->info("File: {}, Path: {}", entry.file_name, entry.full_path());
     }
 
     return actual_files;
@@ -458,58 +444,6 @@ void MainApp::on_analyze_button_clicked(GtkButton *button, gpointer main_app_ins
 }
 
 
-std::vector<FileEntry>
-MainApp::find_files_to_categorize(const std::string& directory_path,
-                                  const std::unordered_set<std::string>& cached_files)
-{
-    std::vector<FileEntry> actual_files =
-        dirscanner.get_directory_entries(directory_path, file_scan_options);
-    core_logger->debug("Directory '{}' has {} actual item(s); {} cached entry name(s) loaded.",
-                       directory_path, actual_files.size(), cached_files.size());
-    std::vector<FileEntry> found_files;
-
-    for (const auto &[full_file_path, file_name, file_type] : actual_files) {
-        if (!cached_files.contains(file_name)) {
-            found_files.push_back({full_file_path, file_name, file_type});
-        }
-    }
-
-    core_logger->debug("{} item(s) require categorization after cache comparison.", found_files.size());
-    return found_files;
-}
-
-
-std::vector<CategorizedFile> MainApp::compute_files_to_sort()
-{
-    std::vector<CategorizedFile> files_to_sort;
-    
-    // Get current files in the directory (full path and name)
-    std::vector<FileEntry> actual_files = dirscanner.get_directory_entries(
-                                              get_folder_path(), file_scan_options
-                                              );
-    core_logger->debug("Computing files to sort. {} entries currently in directory.", actual_files.size());
-    
-    for (const auto &[full_file_path, file_name, file_type] : actual_files) {
-        // Search for each file in already_categorized_files to get its category data
-        auto it = std::find_if(
-            already_categorized_files.begin(), 
-            already_categorized_files.end(),
-            [&file_name, &file_type](const CategorizedFile& categorized_file) {
-                return categorized_file.file_name == file_name && categorized_file.type == file_type;
-            }
-        );
-
-        if (it != already_categorized_files.end()) {
-            // Add files that are found in already_categorized_files with full metadata
-            files_to_sort.push_back(*it);
-        }
-    }
-
-    core_logger->info("{} file(s) ready for move after reconciliation.", files_to_sort.size());
-    return files_to_sort;
-}
-
-
 std::string MainApp::get_folder_path()
 {
     if (!GTK_IS_ENTRY(path_entry)) {
@@ -558,89 +492,386 @@ void MainApp::report_progress(const std::string& message) {
 }
 
 
-std::unique_ptr<ILLMClient> MainApp::make_llm_client() {
+void MainApp::show_error_dialog(const std::string& message) {
+    // Called from the analysis and watcher threads; GTK only runs on the main one.
+    auto error_data = std::make_unique<
+        std::pair<MainApp*, std::string>>(this, message);
+    g_idle_add([](gpointer user_data) -> gboolean {
+        auto error_data = std::unique_ptr<std::pair<MainApp*, std::string>>(
+            static_cast<std::pair<MainApp*, std::string>*>(user_data));
+        DialogUtils::show_error_dialog(GTK_WINDOW(error_data->first->main_window),
+                                       error_data->second);
+        return G_SOURCE_REMOVE;
+    }, error_data.release());
+}
+
+
+std::shared_ptr<ILLMClient> MainApp::make_llm_client() {
     if (settings.get_llm_choice() == LLMChoice::Remote) {
         CategorizationSession categorization_session;
-        return std::make_unique<LLMClient>(
+        return std::make_shared<LLMClient>(
             categorization_session.create_llm_client());
     }
 
+    // The local model stays loaded between analyses; see LocalModelManager.
+    return model_manager.acquire(local_model_path(), settings.get_persist_prompt_cache());
+}
+
+
+std::string MainApp::local_model_path() const
+{
     const char* env_var = settings.get_llm_choice() == LLMChoice::Local_3b
         ? "LOCAL_LLM_3B_DOWNLOAD_URL"
         : "LOCAL_LLM_7B_DOWNLOAD_URL";
 
     std::string url = std::getenv(env_var);
-    return std::make_unique<LocalLLMClient>(
-        Utils::make_default_path_to_file_from_download_url(url));
+    return Utils::make_default_path_to_file_from_download_url(url);
+}
+
+
+void MainApp::preload_local_model()
+{
+    const LLMChoice choice = settings.get_llm_choice();
+    if (choice == LLMChoice::Remote || choice == LLMChoice::Unset) {
+        return;
+    }
+    // Also reached when the user switches to a local model, so the client
+    // never has to change the environment off the UI thread.
+    LocalLLMClient::prepare_environment();
+    if (!settings.get_preload_local_model()) {
+        return;
+    }
+
+    std::string model_path = local_model_path();
+    std::error_code ec;
+    if (!std::filesystem::exists(model_path, ec)) {
+        core_logger->debug("Local model '{}' is not downloaded yet; not preloading it.", model_path);
+        return;
+    }
+    model_manager.preload(model_path, settings.get_persist_prompt_cache());
+}
+
+
+bool MainApp::needs_llm(const FileEntry& entry)
+{
+    // Mirrors categorize_without_llm, so a batch of known files never loads a model.
+    const std::string file_name(entry.file_name);
+    return !db_manager.get_categorization_from_db(file_name, entry.type).has_value() &&
+           !categorization_rules.match(entry.file_name, entry.type).has_value();
 }
 
 
 std::optional<CategorizedFile> MainApp::categorize_single_file(
-    ILLMClient& llm,
-    const FileEntry& entry
+    const std::shared_ptr<ILLMClient>& llm,
+    const FileEntry& entry,
+    const std::atomic<bool>& cancelled
 ) {
-    if (stop_analysis) return std::nullopt;
+    if (cancelled) return std::nullopt;
 
+    const std::string file_name(entry.file_name);
     try {
-        std::string dir_path = std::filesystem::path(entry.full_path)
-                                                .parent_path().string();
-        std::string abbreviated_path = Utils::abbreviate_user_path(entry.full_path);
+        std::string abbreviated_path = Utils::abbreviate_user_path(entry.full_path());
         if (!abbreviated_path.empty()) {
             core_logger->debug("Submitting '{}' (type {}) for categorization. Full path: '{}'",
-                               entry.file_name, to_string(entry.type), abbreviated_path);
+                               file_name, to_string(entry.type), abbreviated_path);
         } else {
-            core_logger->debug("Submitting '{}' (type {}) for categorization.", entry.file_name,
+            core_logger->debug("Submitting '{}' (type {}) for categorization.", file_name,
                                to_string(entry.type));
         }
 
         auto resolved = categorize_file(
-            llm, entry.file_name, abbreviated_path, entry.type,
+            llm, file_name, abbreviated_path,
+            entry.content_type ? entry.content_type : "", entry.type,
             [this](const std::string& msg) {
                 report_progress(msg);
             });
 
-        if (resolved.category.empty() || resolved.subcategory.empty()) {
-            core_logger->warn("Categorization for '{}' returned empty category/subcategory.", entry.file_name);
-            return std::nullopt;
-        }
-
-        core_logger->info("Categorized '{}' as '{} / {}'.", entry.file_name, resolved.category,
-                          resolved.subcategory.empty() ? "<none>" : resolved.subcategory);
-        return CategorizedFile{dir_path, entry.file_name, entry.type,
-                               resolved.category, resolved.subcategory, resolved.taxonomy_id};
+        return to_categorized_file(entry, resolved);
     } catch (const std::exception& ex) {
         std::string error_message = "Error categorizing file \"" +
-            entry.file_name + "\": " + ex.what();
-        DialogUtils::show_error_dialog(GTK_WINDOW(
-            this->main_window), error_message);
+            file_name + "\": " + ex.what();
+        show_error_dialog(error_message);
         core_logger->error("{}", error_message);
         return std::nullopt;
     }
 }
 
 
-std::vector<CategorizedFile> MainApp::categorize_files(
-    const std::vector<FileEntry>& items)
+std::optional<CategorizedFile> MainApp::to_categorized_file(
+    const FileEntry& entry,
+    const DatabaseManager::ResolvedCategory& resolved)
 {
-    std::unique_ptr<ILLMClient> llm = make_llm_client();
-    std::vector<CategorizedFile> categorized_items;
-    core_logger->info("Beginning categorization for {} item(s).", items.size());
+    if (resolved.category.empty() || resolved.subcategory.empty()) {
+        core_logger->warn("Categorization for '{}' returned empty category/subcategory.",
+                          entry.file_name);
+        return std::nullopt;
+    }
 
-    for (const auto& entry : items) {
-        auto result = categorize_single_file(*llm, entry);
-        if (!result.has_value()) break;
-        categorized_items.push_back(std::move(result.value()));
+    core_logger->info("Categorized '{}' as '{} / {}'.", entry.file_name, resolved.category,
+                      resolved.subcategory.empty() ? "<none>" : resolved.subcategory);
+    return CategorizedFile{std::string(entry.directory()), std::string(entry.file_name), entry.type,
+                           resolved.category, resolved.subcategory, resolved.taxonomy_id};
+}
+
+
+std::vector<std::optional<CategorizedFile>> MainApp::categorize_entries(
+    const std::shared_ptr<ILLMClient>& llm,
+    const std::vector<FileEntry>& entries,
+    const std::atomic<bool>& cancelled)
+{
+    std::vector<std::optional<CategorizedFile>> results;
+    results.reserve(entries.size());
+    if (!llm || !using_local_llm || entries.size() == 1) {
+        for (const auto& entry : entries) {
+            results.push_back(categorize_single_file(llm, entry, cancelled));
+        }
+        return results;
     }
 
-    core_logger->info("Finished categorization. {} item(s) processed successfully.",
-                      categorized_items.size());
-    return categorized_items;
+    results.resize(entries.size());
+    if (cancelled) return results;
+
+    auto progress = [this](const std::string& msg) {
+        report_progress(msg);
+    };
+
+    // Cache and rule hits are answered here; the others go to the client
+    // together, so a local model decodes them side by side.
+    std::vector<size_t> asked;
+    std::vector<LLMRequest> requests;
+    std::vector<std::string> paths(entries.size());
+    try {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const FileEntry& entry = entries[i];
+            const std::string file_name(entry.file_name);
+            paths[i] = Utils::abbreviate_user_path(entry.full_path());
+            core_logger->debug("Submitting '{}' (type {}) for batched categorization.", file_name,
+                               to_string(entry.type));
+
+            if (auto resolved = categorize_without_llm(file_name, paths[i], entry.type, progress)) {
+                results[i] = to_categorized_file(entry, *resolved);
+                continue;
+            }
+            asked.push_back(i);
+            requests.push_back({file_name, paths[i],
+                                entry.content_type ? entry.content_type : "", entry.type});
+        }
+        if (requests.empty()) return results;
+
+        std::vector<std::string> answers;
+        try {
+            // Each request keeps the time it would have had on its own.
+            answers = categorize_batch_with_timeout(llm, requests,
+                                                    60 * static_cast<int>(requests.size()));
+        } catch (const std::exception& ex) {
+            for (const auto& request : requests) {
+                report_progress(fmt::format("[TIMEOUT] {} ({})", request.file_name, ex.what()));
+            }
+            core_logger->warn("Categorization timeout/error for a batch of {} item(s): {}",
+                              requests.size(), ex.what());
+            return results;
+        }
+
+        for (size_t k = 0; k < asked.size() && k < answers.size(); ++k) {
+            const size_t i = asked[k];
+            auto resolved = resolve_llm_answer(requests[k].file_name, paths[i], answers[k], progress);
+            results[i] = to_categorized_file(entries[i], resolved);
+        }
+    } catch (const std::exception& ex) {
+        std::string error_message = fmt::format("Error categorizing a batch of {} item(s): {}",
+                                                entries.size(), ex.what());
+        show_error_dialog(error_message);
+        core_logger->error("{}", error_message);
+    }
+    return results;
+}
+
+
+std::vector<CategorizedFile> MainApp::categorize_streamed_files(
+    const std::string& directory_path)
+{
+    // The scan runs on its own thread and hands entries over as soon as each
+    // directory is read, so the first cache hits and LLM requests do not wait
+    // for the whole tree to be enumerated. With content sniffing enabled, a
+    // small pool reads file headers between the scanner and this thread.
+    constexpr size_t scan_queue_capacity = 1024;
+    constexpr size_t max_sniffer_count = 4;
+    const auto cached_index = index_categorized_files(already_categorized_files);
+    const bool sniff_content = settings.get_content_sniffing();
+    BoundedQueue<FileEntry> scanned(scan_queue_capacity);
+    BoundedQueue<FileEntry> sniffed(scan_queue_capacity);
+    BoundedQueue<FileEntry>& pending = sniff_content ? sniffed : scanned;
+    std::exception_ptr scan_error;
+    bool scan_completed = false;
+
+    ScanSnapshotIndex snapshot;
+    db_manager.load_scan_snapshot(directory_path, settings.get_recursive_scan(), snapshot);
+
+    std::thread scanner([&]() {
+        try {
+            scan_completed = dirscanner.scan_directory_entries(
+                directory_path, current_scan_options(),
+                [&](FileEntry&& entry) {
+                    return !stop_analysis && scanned.push(std::move(entry));
+                },
+                settings.get_max_scan_depth(), &snapshot);
+        } catch (...) {
+            scan_error = std::current_exception();
+        }
+        scanned.close();
+    });
+
+    std::vector<std::thread> sniffers;
+    std::atomic<size_t> active_sniffers{0};
+    if (sniff_content) {
+        size_t sniffer_count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, max_sniffer_count);
+        active_sniffers = sniffer_count;
+        for (size_t i = 0; i < sniffer_count; ++i) {
+            sniffers.emplace_back([&]() {
+                std::string path;
+                while (auto entry = scanned.pop()) {
+                    // Cached entries never reach the LLM, so their headers are not read.
+                    if (entry->type == FileType::File) {
+                        path.clear();
+                        entry->append_full_path(path);
+                        if (!cached_index.contains(path)) {
+                            entry->content_type = ContentSniffer::sniff(path);
+                        }
+                    }
+                    if (!sniffed.push(std::move(*entry))) break;
+                }
+                if (active_sniffers.fetch_sub(1) == 1) {
+                    sniffed.close();
+                }
+            });
+        }
+    }
+
+    auto finish_pipeline = [&]() {
+        scanned.close();
+        sniffed.close();
+        scanner.join();
+        for (auto& sniffer : sniffers) {
+            sniffer.join();
+        }
+    };
+
+    std::vector<CategorizedFile> files_to_sort;
+    std::shared_ptr<ILLMClient> llm;
+    size_t scanned_count = 0;
+    size_t failed_count = 0;
+    std::string entry_path;
+
+    std::vector<FileEntry> group;
+
+    auto take = [&](FileEntry&& entry) {
+        ++scanned_count;
+        entry_path.clear();
+        entry.append_full_path(entry_path);
+        auto cached = cached_index.find(entry_path);
+        if (cached != cached_index.end()) {
+            const auto& categorized_file = already_categorized_files[cached->second];
+            if (categorized_file.type == entry.type) {
+                files_to_sort.push_back(categorized_file);
+            }
+            return;
+        }
+
+        if (!llm && needs_llm(entry)) {
+            report_progress("[PROCESS] Letting the AI do its magic...");
+            llm = make_llm_client();
+            core_logger->info("Beginning categorization while '{}' is being scanned.",
+                              directory_path);
+        }
+        group.push_back(std::move(entry));
+    };
+
+    try {
+        while (auto entry = pending.pop()) {
+            take(std::move(*entry));
+            // Entries that are already waiting join the group, up to what the
+            // client answers at once; a partial group is sent rather than
+            // held back for the scan.
+            while (group.size() < (llm ? llm->max_batch_size() : 1)) {
+                auto next = pending.try_pop();
+                if (!next) break;
+                take(std::move(*next));
+            }
+            if (group.empty()) continue;
+
+            std::vector<std::optional<CategorizedFile>> results;
+            {
+                std::lock_guard<std::mutex> categorization_lock(categorization_mutex);
+                results = categorize_entries(llm, group, stop_analysis);
+            }
+            group.clear();
+            // Items that timed out or failed were reported as such and are
+            // left uncategorized; the rest of the tree is still analyzed.
+            for (auto& result : results) {
+                if (!result.has_value()) {
+                    if (!stop_analysis) ++failed_count;
+                    continue;
+                }
+                new_files_with_categories.push_back(*result);
+                files_to_sort.push_back(std::move(*result));
+            }
+            if (stop_analysis) break;
+        }
+    } catch (...) {
+        finish_pipeline();
+        throw;
+    }
+
+    finish_pipeline();
+    if (scan_error) {
+        std::rethrow_exception(scan_error);
+    }
+    // Listings of directories the scan did not reach are only dropped after
+    // a complete scan; a stopped one says nothing about them.
+    db_manager.save_scan_snapshot(snapshot, scan_completed);
+
+    if (new_files_with_categories.empty()) {
+        report_progress("[DONE] No files to categorize.");
+    }
+
+    core_logger->info("{} item(s) streamed from '{}'; {} categorized, {} failed, {} ready for sorting.",
+                      scanned_count, directory_path, new_files_with_categories.size(),
+                      failed_count, files_to_sort.size());
+    return files_to_sort;
+}
+
+
+std::vector<std::string> MainApp::categorize_batch_with_timeout(
+    std::shared_ptr<ILLMClient> llm, std::vector<LLMRequest> requests, int timeout_seconds)
+{
+    core_logger->debug("Issuing categorize request for {} item(s) with timeout {}s.",
+                       requests.size(), timeout_seconds);
+    std::promise<std::vector<std::string>> promise;
+    std::future<std::vector<std::string>> future = promise.get_future();
+
+    std::thread([llm = std::move(llm), promise = std::move(promise),
+                 requests = std::move(requests)]()mutable {
+        try {
+            promise.set_value(llm->categorize_batch(requests));
+        } catch (const std::exception& e) {
+            promise.set_exception(std::current_exception());
+        }
+    }).detach();
+
+    if (future.wait_for(std::chrono::seconds(timeout_seconds)) ==
+        std::future_status::ready) {
+        return future.get();
+    } else {
+        throw std::runtime_error(
+            "Network timeout: LLM response took too long.");
+    }
 }
 
 
 std::string MainApp::categorize_with_timeout(
-    ILLMClient& llm, const std::string& item_name,
+    std::shared_ptr<ILLMClient> llm, const std::string& item_name,
     const std::string& item_path,
+    const std::string& content_type,
     const FileType file_type, int timeout_seconds)
 {
     core_logger->debug("Issuing categorize request for '{}' ({}) with timeout {}s.",
@@ -648,10 +879,10 @@ std::string MainApp::categorize_with_timeout(
     std::promise<std::string> promise;
     std::future<std::string> future = promise.get_future();
 
-    std::thread([&llm, promise = std::move(promise), item_name,
-                item_path, file_type]()mutable {
+    std::thread([llm = std::move(llm), promise = std::move(promise), item_name,
+                item_path, content_type, file_type]()mutable {
         try {
-            std::string result = llm.categorize_file(item_name, item_path, file_type);
+            std::string result = llm->categorize_file(item_name, item_path, content_type, file_type);
             promise.set_value(result);
         } catch (const std::exception& e) {
             promise.set_exception(std::current_exception());
@@ -669,19 +900,15 @@ std::string MainApp::categorize_with_timeout(
 }
 
 
-DatabaseManager::ResolvedCategory
-MainApp::categorize_file(ILLMClient& llm, const std::string& item_name,
-                         const std::string& item_path,
-                         const FileType file_type,
-                         const std::function<void(const std::string&)>& report_progress)
+std::optional<DatabaseManager::ResolvedCategory>
+MainApp::categorize_without_llm(const std::string& item_name,
+                                const std::string& item_path,
+                                const FileType file_type,
+                                const std::function<void(const std::string&)>& report_progress)
 {
     // Check the local database with the item name and type
-    auto categorization = db_manager.get_categorization_from_db(item_name, file_type);
-    if (categorization.size() >= 2) {
-        std::string category = categorization[0];
-        std::string subcategory = categorization[1];
-
-        auto resolved = db_manager.resolve_category(category, subcategory);
+    if (auto cached = db_manager.get_categorization_from_db(item_name, file_type)) {
+        const auto &resolved = *cached;
         core_logger->info("Found in local DB: {} - Category: {}, Subcategory: {}", item_name,
                           resolved.category, resolved.subcategory);
 
@@ -695,6 +922,64 @@ MainApp::categorize_file(ILLMClient& llm, const std::string& item_name,
         return resolved;
     }
 
+    // Well-known extensions are categorized by rule, without asking the LLM
+    if (auto rule = categorization_rules.match(item_name, file_type)) {
+        auto resolved = db_manager.resolve_category(std::string(rule->category),
+                                                    std::string(rule->subcategory));
+        core_logger->debug("Rule matched: {} - Category: {}, Subcategory: {}", item_name,
+                           resolved.category, resolved.subcategory);
+
+        std::string path_display = item_path.empty() ? "-" : item_path;
+        std::string message = fmt::format(
+            "[RULE] {}\n    Category : {}\n    Subcat   : {}\n    Path     : {}",
+            item_name, resolved.category, resolved.subcategory, path_display);
+        report_progress(message);
+        return resolved;
+    }
+
+    return std::nullopt;
+}
+
+
+DatabaseManager::ResolvedCategory
+MainApp::resolve_llm_answer(const std::string& item_name,
+                            const std::string& item_path,
+                            const std::string& category_subcategory,
+                            const std::function<void(const std::string&)>& report_progress)
+{
+    auto [category, subcategory] =
+        split_category_subcategory(category_subcategory);
+
+    auto resolved = db_manager.resolve_category(category, subcategory);
+
+    std::string sub = resolved.subcategory.empty() ? "-" : resolved.subcategory;
+    std::string path_display = item_path.empty() ? "-" : item_path;
+
+    std::string message = fmt::format(
+        "[AI] {}\n    Category : {}\n    Subcat   : {}\n    Path     : {}",
+        item_name, resolved.category, sub, path_display);
+    report_progress(message);
+
+    return resolved;
+}
+
+
+DatabaseManager::ResolvedCategory
+MainApp::categorize_file(const std::shared_ptr<ILLMClient>& llm, const std::string& item_name,
+                         const std::string& item_path,
+                         const std::string& content_type,
+                         const FileType file_type,
+                         const std::function<void(const std::string&)>& report_progress)
+{
+    if (auto resolved = categorize_without_llm(item_name, item_path, file_type, report_progress)) {
+        return *resolved;
+    }
+
+    if (!llm) {
+        core_logger->error("No LLM client available to categorize '{}'.", item_name);
+        return DatabaseManager::ResolvedCategory{-1, "", ""};
+    }
+
     if (!using_local_llm) {
         const char* env_pc = std::getenv("ENV_PC");
         const char* env_rr = std::getenv("ENV_RR");
@@ -717,10 +1002,10 @@ MainApp::categorize_file(ILLMClient& llm, const std::string& item_name,
             if (using_local_llm) {
                 // Wait 30 seconds if using a local LLM
                 category_subcategory = categorize_with_timeout(
-                    llm, item_name, item_path, file_type, 60);
+                    llm, item_name, item_path, content_type, file_type, 60);
             } else {
                 category_subcategory = categorize_with_timeout(
-                    llm, item_name, item_path, file_type, 10);
+                    llm, item_name, item_path, content_type, file_type, 10);
             }
         } catch (const std::exception& ex) {
             std::string timeout_message = fmt::format("[TIMEOUT] {} ({})", item_name, ex.what());
@@ -729,20 +1014,7 @@ MainApp::categorize_file(ILLMClient& llm, const std::string& item_name,
             return DatabaseManager::ResolvedCategory{-1, "", ""};
         }
 
-        auto [category, subcategory] =
-            split_category_subcategory(category_subcategory);
-
-        auto resolved = db_manager.resolve_category(category, subcategory);
-
-        std::string sub = resolved.subcategory.empty() ? "-" : resolved.subcategory;
-        std::string path_display = item_path.empty() ? "-" : item_path;
-
-        std::string message = fmt::format(
-            "[AI] {}\n    Category : {}\n    Subcat   : {}\n    Path     : {}",
-            item_name, resolved.category, sub, path_display);
-        report_progress(message);
-
-        return resolved;
+        return resolve_llm_answer(item_name, item_path, category_subcategory, report_progress);
     } catch (const std::exception& ex) {
         std::string err_msg = fmt::format("[LLM-ERROR] {} ({})", item_name, ex.what());
         report_progress(err_msg);
@@ -819,6 +1091,141 @@ void MainApp::setup_menu_item_file_explorer()
 }
 
 
+void MainApp::setup_menu_item_watch_folder()
+{
+    if (!DirectoryWatcher::is_supported()) {
+        return;
+    }
+
+    // Added here rather than in main_window.glade so the item only exists
+    // on platforms that can watch folders.
+    GtkWidget *file_explorer_item = GTK_WIDGET(gtk_builder_get_object(builder, "view-file-explorer"));
+    GtkWidget *view_menu = file_explorer_item ? gtk_widget_get_parent(file_explorer_item) : nullptr;
+    if (!view_menu || !GTK_IS_MENU_SHELL(view_menu)) {
+        g_critical("Failed to find the View menu for 'Watch Folder'.");
+        return;
+    }
+
+    GtkWidget *watch_item = gtk_check_menu_item_new_with_label("Watch Folder");
+    gtk_widget_set_tooltip_text(watch_item,
+        "Categorize new files as they arrive in the selected folder");
+    gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), watch_item);
+    g_signal_connect(watch_item, "toggled", G_CALLBACK(on_toggle_watch_folder), this);
+    gtk_widget_show(watch_item);
+}
+
+
+void MainApp::on_toggle_watch_folder(GtkCheckMenuItem *menu_item, gpointer user_data)
+{
+    MainApp *app = static_cast<MainApp *>(user_data);
+
+    if (!gtk_check_menu_item_get_active(menu_item)) {
+        app->stop_watching();
+        return;
+    }
+
+    if (!app->start_watching()) {
+        // Unchecking re-enters this handler, which is harmless when idle.
+        gtk_check_menu_item_set_active(menu_item, FALSE);
+    }
+}
+
+
+bool MainApp::start_watching()
+{
+    if (directory_watcher.is_stopping()) {
+        // Joining it here would block the UI until its batch is done.
+        DialogUtils::show_error_dialog(GTK_WINDOW(main_window),
+                                       "Watch mode is still finishing its last batch. Try again in a moment.");
+        return false;
+    }
+
+    std::string directory_path = get_folder_path();
+    if (!Utils::is_valid_directory(directory_path.c_str())) {
+        DialogUtils::show_error_dialog(GTK_WINDOW(main_window), ERR_INVALID_PATH);
+        core_logger->warn("Cannot watch invalid directory '{}'", directory_path);
+        return false;
+    }
+
+    watch_cancelled = false;
+    bool started = directory_watcher.start(
+        directory_path, current_scan_options(), settings.get_max_scan_depth(),
+        [this](std::vector<FileEntry>&& entries) {
+            categorize_watched_files(std::move(entries));
+        },
+        name_filter);
+    if (!started) {
+        DialogUtils::show_error_dialog(GTK_WINDOW(main_window), "Could not watch the selected folder.");
+        return false;
+    }
+
+    core_logger->info("Watch mode enabled for '{}'", directory_path);
+    return true;
+}
+
+
+void MainApp::stop_watching()
+{
+    if (!directory_watcher.is_running()) {
+        return;
+    }
+    // Called on the UI thread: the watcher may be in the middle of a batch,
+    // so it is only told to stop; the batch ends at the next item.
+    watch_cancelled = true;
+    directory_watcher.request_stop();
+    core_logger->info("Watch mode disabled");
+}
+
+
+void MainApp::categorize_watched_files(std::vector<FileEntry>&& entries)
+{
+    core_logger->info("Watch mode: {} new item(s) to categorize.", entries.size());
+
+    const bool sniff_content = settings.get_content_sniffing();
+    std::vector<DatabaseManager::CategorizationRecord> records;
+    std::vector<FileEntry> group;
+    // Held for this batch only; between batches a local model may be
+    // unloaded when idle or when memory runs low.
+    std::shared_ptr<ILLMClient> llm;
+    for (auto it = entries.begin(); it != entries.end() && !watch_cancelled; ) {
+        group.clear();
+        while (it != entries.end() &&
+               group.size() < (llm ? llm->max_batch_size() : 1)) {
+            FileEntry& entry = *it++;
+            if (sniff_content && entry.type == FileType::File) {
+                entry.content_type = ContentSniffer::sniff(entry.full_path());
+            }
+            if (!llm && needs_llm(entry)) {
+                try {
+                    llm = make_llm_client();
+                } catch (const std::exception& ex) {
+                    core_logger->error("Watch mode could not create the LLM client: {}", ex.what());
+                    it = entries.end();
+                    break;
+                }
+            }
+            group.push_back(std::move(entry));
+        }
+
+        std::vector<std::optional<CategorizedFile>> results;
+        {
+            std::lock_guard<std::mutex> categorization_lock(categorization_mutex);
+            results = categorize_entries(llm, group, watch_cancelled);
+        }
+        for (auto& result : results) {
+            if (!result.has_value()) continue;
+            records.push_back({result->file_name, result->type == FileType::File ? "F" : "D",
+                               result->file_path,
+                               {result->taxonomy_id, result->category, result->subcategory}});
+        }
+    }
+
+    size_t queued = db_manager.insert_or_update_files_with_categorization(records) ? records.size() : 0;
+    core_logger->info("Watch mode: queued {} of {} new categorization(s) for storage.", queued,
+                      entries.size());
+}
+
+
 void MainApp::on_directory_selected(GtkFileChooser *file_chooser, gpointer user_data)
 {
     MainApp *app = static_cast<MainApp *>(user_data);
@@ -871,6 +1278,7 @@ void MainApp::on_activate()
         setup_main_window();
         initialize_ui_components();
         start_updater();
+        preload_local_model();
     } catch (const std::exception &e) {
         ui_logger->critical("Exception in MainApp::on_activate: {}", e.what());
     }
@@ -915,6 +1323,7 @@ void MainApp::initialize_ui_components()
     categorization_dialog = new CategorizationDialog(&db_manager, show_subcategory_col);
     connect_ui_signals();
     setup_menu_item_file_explorer();
+    setup_menu_item_watch_folder();
     load_settings();
 }
 
@@ -1091,6 +1500,7 @@ void MainApp::show_llm_selection_dialog() {
     if (response == GTK_RESPONSE_OK) {
         settings.set_llm_choice(dialog->get_selected_llm_choice());
         settings.save();
+        preload_local_model();
     }
 }
 
@@ -1107,6 +1517,9 @@ void MainApp::shutdown()
         stop_analysis = true;
         analyze_thread.join();
     }
+    stop_watching();
+    // Quitting may wait for the watcher; it stops at its next item.
+    directory_watcher.stop();
 
     g_signal_handlers_disconnect_by_data(categorize_files_checkbox, this);
     g_signal_handlers_disconnect_by_data(categorize_directories_checkbox, this);
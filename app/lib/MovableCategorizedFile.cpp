@@ -29,6 +29,19 @@ MovableCategorizedFile::MovableCategorizedFile(
 }
 
 
+std::filesystem::path MovableCategorizedFile::missing_cat_dir(bool use_subcategory) const
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(category_path, ec)) {
+        return category_path;
+    }
+    if (use_subcategory && !std::filesystem::exists(subcategory_path, ec)) {
+        return subcategory_path;
+    }
+    return {};
+}
+
+
 void MovableCategorizedFile::create_cat_dirs(bool use_subcategory)
 {
     try {
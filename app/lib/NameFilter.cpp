@@ -0,0 +1,289 @@
+#include "NameFilter.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <map>
+
+namespace {
+
+using ByteSet = std::bitset<256>;
+
+// One step of a compiled glob: either a set of bytes consumed exactly once,
+// or '*', which consumes any number of bytes.
+struct GlobToken {
+    ByteSet bytes;
+    bool star{false};
+};
+
+struct GlobPattern {
+    std::vector<GlobToken> tokens;
+    std::uint8_t flag;
+};
+
+constexpr size_t kMaxStates = 4096;
+
+bool parse_bracket(std::string_view pattern, size_t &pos, ByteSet &bytes)
+{
+    // pos points just past '['
+    size_t i = pos;
+    bool negate = false;
+    if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^')) {
+        negate = true;
+        ++i;
+    }
+    bool first = true;
+    while (i < pattern.size() && (first || pattern[i] != ']')) {
+        first = false;
+        unsigned char low = static_cast<unsigned char>(pattern[i]);
+        if (low == '\\' && i + 1 < pattern.size()) {
+            low = static_cast<unsigned char>(pattern[++i]);
+        }
+        ++i;
+        unsigned char high = low;
+        if (i + 1 < pattern.size() && pattern[i] == '-' && pattern[i + 1] != ']') {
+            high = static_cast<unsigned char>(pattern[i + 1]);
+            i += 2;
+        }
+        for (unsigned c = low; c <= high; ++c) {
+            bytes.set(c);
+        }
+    }
+    if (i >= pattern.size()) {
+        return false;
+    }
+    if (negate) {
+        bytes.flip();
+    }
+    pos = i + 1;
+    return true;
+}
+
+bool parse_glob(std::string_view pattern, std::uint8_t flag, GlobPattern &out)
+{
+    out.flag = flag;
+    for (size_t i = 0; i < pattern.size();) {
+        GlobToken token;
+        char c = pattern[i];
+        if (c == '*') {
+            // Consecutive stars are equivalent to one.
+            if (out.tokens.empty() || !out.tokens.back().star) {
+                token.star = true;
+                out.tokens.push_back(token);
+            }
+            ++i;
+            continue;
+        }
+        if (c == '?') {
+            token.bytes.set();
+            ++i;
+        } else if (c == '[') {
+            ++i;
+            if (!parse_bracket(pattern, i, token.bytes)) {
+                return false;
+            }
+        } else {
+            if (c == '\\' && i + 1 < pattern.size()) {
+                c = pattern[++i];
+            }
+            token.bytes.set(static_cast<unsigned char>(c));
+            ++i;
+        }
+        out.tokens.push_back(token);
+    }
+    return !out.tokens.empty();
+}
+
+// NFA states are (pattern, position) pairs, numbered consecutively across
+// all patterns; position == tokens.size() is the accepting position.
+class GlobNfa {
+public:
+    explicit GlobNfa(const std::vector<GlobPattern> &patterns) : patterns(patterns) {
+        size_t next = 0;
+        for (const auto &pattern : patterns) {
+            first_state.push_back(next);
+            next += pattern.tokens.size() + 1;
+        }
+    }
+
+    std::vector<size_t> start() const {
+        std::vector<size_t> states;
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            add_closed(p, 0, states);
+        }
+        return normalize(std::move(states));
+    }
+
+    std::vector<size_t> step(const std::vector<size_t> &states, unsigned char byte) const {
+        std::vector<size_t> next;
+        for (size_t state : states) {
+            auto [p, pos] = locate(state);
+            const auto &tokens = patterns[p].tokens;
+            if (pos == tokens.size()) continue;
+            const auto &token = tokens[pos];
+            if (token.star) {
+                add_closed(p, pos, next);
+            } else if (token.bytes.test(byte)) {
+                add_closed(p, pos + 1, next);
+            }
+        }
+        return normalize(std::move(next));
+    }
+
+    std::uint8_t accepting(const std::vector<size_t> &states) const {
+        std::uint8_t flags = 0;
+        for (size_t state : states) {
+            auto [p, pos] = locate(state);
+            if (pos == patterns[p].tokens.size()) {
+                flags |= patterns[p].flag;
+            }
+        }
+        return flags;
+    }
+
+private:
+    // A star may match nothing, so reaching it also reaches the position after it.
+    void add_closed(size_t p, size_t pos, std::vector<size_t> &states) const {
+        const auto &tokens = patterns[p].tokens;
+        states.push_back(first_state[p] + pos);
+        while (pos < tokens.size() && tokens[pos].star) {
+            states.push_back(first_state[p] + ++pos);
+        }
+    }
+
+    std::pair<size_t, size_t> locate(size_t state) const {
+        auto it = std::upper_bound(first_state.begin(), first_state.end(), state);
+        size_t p = static_cast<size_t>(it - first_state.begin()) - 1;
+        return {p, state - first_state[p]};
+    }
+
+    static std::vector<size_t> normalize(std::vector<size_t> states) {
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()), states.end());
+        return states;
+    }
+
+    const std::vector<GlobPattern> &patterns;
+    std::vector<size_t> first_state;
+};
+
+} // namespace
+
+
+NameFilter::NameFilter(const std::vector<std::string> &exclude_patterns,
+                       const std::vector<std::string> &include_patterns)
+{
+    auto logger = Logger::get_logger("core_logger");
+    std::vector<GlobPattern> patterns;
+
+    auto add_patterns = [&](const std::vector<std::string> &sources, std::uint8_t flag) {
+        for (const auto &source : sources) {
+            if (source.empty()) continue;
+            GlobPattern pattern;
+            if (source.find('/') != std::string::npos || !parse_glob(source, flag, pattern)) {
+                if (logger) {
+                    logger->warn("Ignoring invalid name pattern '{}'", source);
+                }
+                continue;
+            }
+            if (flag == kInclude) {
+                has_include = true;
+            }
+            patterns.push_back(std::move(pattern));
+        }
+    };
+    add_patterns(exclude_patterns, kExclude);
+    add_patterns(include_patterns, kInclude);
+    if (patterns.empty()) {
+        return;
+    }
+
+    // Bytes that no pattern tells apart share a column of the transition table.
+    std::vector<ByteSet> distinct_sets;
+    for (const auto &pattern : patterns) {
+        for (const auto &token : pattern.tokens) {
+            if (!token.star) distinct_sets.push_back(token.bytes);
+        }
+    }
+    std::map<std::vector<bool>, std::uint8_t> signatures;
+    for (unsigned byte = 0; byte < 256; ++byte) {
+        std::vector<bool> signature;
+        signature.reserve(distinct_sets.size());
+        for (const auto &set : distinct_sets) {
+            signature.push_back(set.test(byte));
+        }
+        auto [it, inserted] = signatures.emplace(std::move(signature),
+                                                 static_cast<std::uint8_t>(signatures.size()));
+        byte_class[byte] = it->second;
+    }
+    class_count = signatures.size();
+    std::vector<unsigned char> representative(class_count);
+    for (unsigned byte = 256; byte-- > 0;) {
+        representative[byte_class[byte]] = static_cast<unsigned char>(byte);
+    }
+
+    // Subset construction; state 0 is the dead state, state 1 the start.
+    GlobNfa nfa(patterns);
+    std::map<std::vector<size_t>, StateId> state_ids;
+    std::vector<std::vector<size_t>> worklist;
+    auto intern = [&](std::vector<size_t> states) -> StateId {
+        auto [it, inserted] = state_ids.emplace(states, static_cast<StateId>(accepting.size()));
+        if (inserted) {
+            accepting.push_back(nfa.accepting(states));
+            transitions.resize(accepting.size() * class_count, 0);
+            worklist.push_back(std::move(states));
+        }
+        return it->second;
+    };
+    intern({});
+    intern(nfa.start());
+
+    for (size_t next = 1; next < worklist.size(); ++next) {
+        if (accepting.size() > kMaxStates) {
+            if (logger) {
+                logger->warn("Name patterns are too complex ({}+ states); filtering disabled",
+                             kMaxStates);
+            }
+            transitions.clear();
+            accepting.clear();
+            has_include = false;
+            return;
+        }
+        const auto states = worklist[next];
+        for (size_t cls = 0; cls < class_count; ++cls) {
+            StateId target = intern(nfa.step(states, representative[cls]));
+            transitions[next * class_count + cls] = target;
+        }
+    }
+
+    if (logger) {
+        logger->debug("Compiled {} name pattern(s) into {} DFA states over {} byte classes",
+                      patterns.size(), accepting.size(), class_count);
+    }
+}
+
+
+bool NameFilter::accepts_file(std::string_view name) const
+{
+    std::uint8_t flags = evaluate(name);
+    if (flags & kExclude) {
+        return false;
+    }
+    return !has_include || (flags & kInclude);
+}
+
+
+std::uint8_t NameFilter::evaluate(std::string_view name) const
+{
+    if (transitions.empty()) {
+        return 0;
+    }
+    StateId state = 1;
+    for (char c : name) {
+        state = transitions[state * class_count + byte_class[static_cast<unsigned char>(c)]];
+        if (state == 0) {
+            return 0;
+        }
+    }
+    return accepting[state];
+}
@@ -0,0 +1,92 @@
+#include "PathTable.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+
+StringArena::StringArena(size_t block_size)
+    : block_size(block_size)
+{
+}
+
+
+std::string_view StringArena::store(std::string_view text)
+{
+    if (text.empty()) {
+        return {};
+    }
+
+    if (text.size() > remaining) {
+        // Oversized strings get a block of their own so the current block
+        // can keep filling up.
+        if (text.size() > block_size / 4) {
+            blocks.push_back(std::make_unique<char[]>(text.size()));
+            reserved += text.size();
+            std::memcpy(blocks.back().get(), text.data(), text.size());
+            return {blocks.back().get(), text.size()};
+        }
+        blocks.push_back(std::make_unique<char[]>(block_size));
+        reserved += block_size;
+        cursor = blocks.back().get();
+        remaining = block_size;
+    }
+
+    char *stored = cursor;
+    std::memcpy(stored, text.data(), text.size());
+    cursor += text.size();
+    remaining -= text.size();
+    return {stored, text.size()};
+}
+
+
+PathTable::PathTable()
+    : directory_storage(16 * 1024)
+{
+}
+
+
+PathTable::DirId PathTable::intern_directory(std::string_view dir_path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = directory_ids.find(dir_path);
+    if (it != directory_ids.end()) {
+        return it->second;
+    }
+
+    DirId id = count.load(std::memory_order_relaxed);
+    size_t segment = id / kSegmentSize;
+    if (segment >= kMaxSegments) {
+        throw std::length_error("PathTable directory limit reached");
+    }
+    if (!segments[segment]) {
+        segments[segment] = std::make_unique<Segment>();
+    }
+
+    std::string_view stored = directory_storage.store(dir_path);
+    (*segments[segment])[id % kSegmentSize] = stored;
+    directory_ids.emplace(stored, id);
+    count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+
+std::string_view PathTable::directory(DirId id) const
+{
+    if (id >= count.load(std::memory_order_acquire)) {
+        return {};
+    }
+    return (*segments[id / kSegmentSize])[id % kSegmentSize];
+}
+
+
+size_t PathTable::directory_count() const
+{
+    return count.load(std::memory_order_acquire);
+}
+
+
+StringArena &PathTable::make_arena()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return arenas.emplace_back();
+}
@@ -0,0 +1,125 @@
+#include "ReadConnectionPool.hpp"
+#include "Logger.hpp"
+
+#include <cstdio>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/fmt.h>
+
+namespace {
+
+template <typename... Args>
+void pool_log(spdlog::level::level_enum level, const char* fmt, Args&&... args) {
+    auto message = fmt::format(fmt::runtime(fmt), std::forward<Args>(args)...);
+    if (auto logger = Logger::get_logger("core_logger")) {
+        logger->log(level, "{}", message);
+    } else {
+        std::fprintf(stderr, "%s\n", message.c_str());
+    }
+}
+
+} // namespace
+
+
+struct ReadConnectionPool::Connection {
+    sqlite3 *db{nullptr};
+    std::vector<sqlite3_stmt *> statements;
+
+    ~Connection() {
+        for (sqlite3_stmt *stmt : statements) {
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db);
+    }
+};
+
+
+ReadConnectionPool::Lease::Lease(ReadConnectionPool *pool, std::unique_ptr<Connection> connection)
+    : pool(pool), connection(std::move(connection))
+{
+}
+
+
+ReadConnectionPool::Lease::Lease(Lease &&other) noexcept
+    : pool(other.pool), connection(std::move(other.connection))
+{
+}
+
+
+ReadConnectionPool::Lease::~Lease()
+{
+    if (connection) {
+        pool->release(std::move(connection));
+    }
+}
+
+
+sqlite3 *ReadConnectionPool::Lease::db() const
+{
+    return connection ? connection->db : nullptr;
+}
+
+
+sqlite3_stmt *ReadConnectionPool::Lease::statement(size_t slot, const char *sql)
+{
+    if (!connection || slot >= connection->statements.size()) {
+        return nullptr;
+    }
+    sqlite3_stmt *&stmt = connection->statements[slot];
+    if (!stmt &&
+        sqlite3_prepare_v3(connection->db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        pool_log(spdlog::level::err, "Failed to prepare statement: {}", sqlite3_errmsg(connection->db));
+        sqlite3_finalize(stmt);
+        stmt = nullptr;
+    }
+    return stmt;
+}
+
+
+ReadConnectionPool::ReadConnectionPool(std::string db_file, size_t statement_slots)
+    : db_file(std::move(db_file)), statement_slots(statement_slots)
+{
+}
+
+
+ReadConnectionPool::~ReadConnectionPool() = default;
+
+
+ReadConnectionPool::Lease ReadConnectionPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            std::unique_ptr<Connection> connection = std::move(idle.back());
+            idle.pop_back();
+            return Lease(this, std::move(connection));
+        }
+    }
+    return Lease(this, open_connection());
+}
+
+
+std::unique_ptr<ReadConnectionPool::Connection> ReadConnectionPool::open_connection() const
+{
+    auto connection = std::make_unique<Connection>();
+    // A lease is used by one thread at a time, so SQLite's own locking
+    // around the connection is not needed.
+    const int flags = SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(db_file.c_str(), &connection->db, flags, nullptr) != SQLITE_OK) {
+        pool_log(spdlog::level::err, "Can't open database for reading: {}",
+                 connection->db ? sqlite3_errmsg(connection->db) : "out of memory");
+        return nullptr;
+    }
+    sqlite3_extended_result_codes(connection->db, 1);
+    sqlite3_busy_timeout(connection->db, 5000);
+    connection->statements.assign(statement_slots, nullptr);
+    return connection;
+}
+
+
+void ReadConnectionPool::release(std::unique_ptr<Connection> connection)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.push_back(std::move(connection));
+}
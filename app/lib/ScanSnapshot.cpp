@@ -0,0 +1,69 @@
+#include "ScanSnapshot.hpp"
+
+
+ScanSnapshotIndex::SnapshotPtr ScanSnapshotIndex::find(const std::string &dir_path) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = directories.find(dir_path);
+    return it != directories.end() ? it->second.snapshot : nullptr;
+}
+
+
+void ScanSnapshotIndex::load(std::string dir_path, DirectorySnapshot snapshot)
+{
+    auto shared = std::make_shared<const DirectorySnapshot>(std::move(snapshot));
+    std::lock_guard<std::mutex> lock(mutex);
+    directories[std::move(dir_path)] = Slot{std::move(shared), false, false};
+}
+
+
+void ScanSnapshotIndex::update(std::string dir_path, DirectorySnapshot snapshot)
+{
+    auto shared = std::make_shared<const DirectorySnapshot>(std::move(snapshot));
+    std::lock_guard<std::mutex> lock(mutex);
+    directories[std::move(dir_path)] = Slot{std::move(shared), true, true};
+}
+
+
+void ScanSnapshotIndex::mark_visited(const std::string &dir_path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = directories.find(dir_path);
+    if (it != directories.end()) {
+        it->second.visited = true;
+    }
+}
+
+
+std::vector<std::pair<std::string, ScanSnapshotIndex::SnapshotPtr>> ScanSnapshotIndex::take_dirty()
+{
+    std::vector<std::pair<std::string, SnapshotPtr>> dirty;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &[dir_path, slot] : directories) {
+        if (slot.dirty) {
+            dirty.emplace_back(dir_path, slot.snapshot);
+            slot.dirty = false;
+        }
+    }
+    return dirty;
+}
+
+
+std::vector<std::string> ScanSnapshotIndex::unvisited_directories() const
+{
+    std::vector<std::string> unvisited;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &[dir_path, slot] : directories) {
+        if (!slot.visited) {
+            unvisited.push_back(dir_path);
+        }
+    }
+    return unvisited;
+}
+
+
+size_t ScanSnapshotIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return directories.size();
+}
@@ -23,6 +23,34 @@ void settings_log(spdlog::level::level_enum level, const char* fmt, Args&&... ar
         std::fprintf(stderr, "%s\n", message.c_str());
     }
 }
+
+// Pattern lists are stored as one ';'-separated value. IniConfig drops keys
+// with an empty value, so an empty list is written as a lone separator.
+std::vector<std::string> split_patterns(const std::string &value) {
+    std::vector<std::string> patterns;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(';', start);
+        if (end == std::string::npos) end = value.size();
+        std::string pattern = value.substr(start, end - start);
+        size_t first = pattern.find_first_not_of(" \t");
+        if (first != std::string::npos) {
+            size_t last = pattern.find_last_not_of(" \t");
+            patterns.push_back(pattern.substr(first, last - first + 1));
+        }
+        start = end + 1;
+    }
+    return patterns;
+}
+
+std::string join_patterns(const std::vector<std::string> &patterns) {
+    std::string value;
+    for (const auto &pattern : patterns) {
+        if (!value.empty()) value += ';';
+        value += pattern;
+    }
+    return value.empty() ? ";" : value;
+}
 }
 
 
@@ -31,7 +59,14 @@ Settings::Settings()
       categorize_files(true),
       categorize_directories(false),
       default_sort_folder(""),
-      sort_folder("")
+      sort_folder(""),
+      recursive_scan(false),
+      max_scan_depth(0),
+      content_sniffing(true),
+      persist_prompt_cache(false),
+      preload_local_model(true),
+      local_model_idle_minutes(10),
+      exclude_patterns{"*.part", "*.crdownload", "~$*"}
 {
     std::string AppName = "AIFileSorter";
     config_path = define_config_path();
@@ -93,6 +128,23 @@ bool Settings::load()
     categorize_files = config.getValue("Settings", "CategorizeFiles", "true") == "true";
     categorize_directories = config.getValue("Settings", "CategorizeDirectories", "false") == "true";
     sort_folder = config.getValue("Settings", "SortFolder", default_sort_folder ? default_sort_folder : "/");
+    recursive_scan = config.getValue("Settings", "RecursiveScan", "false") == "true";
+    try {
+        max_scan_depth = std::stoi(config.getValue("Settings", "MaxScanDepth", "0"));
+    } catch (const std::exception &) {
+        max_scan_depth = 0;
+    }
+    content_sniffing = config.getValue("Settings", "ContentSniffing", "true") == "true";
+    persist_prompt_cache = config.getValue("Settings", "PersistPromptCache", "false") == "true";
+    preload_local_model = config.getValue("Settings", "PreloadLocalModel", "true") == "true";
+    try {
+        local_model_idle_minutes = std::stoi(config.getValue("Settings", "LocalModelIdleMinutes", "10"));
+    } catch (const std::exception &) {
+        local_model_idle_minutes = 10;
+    }
+    exclude_patterns = split_patterns(config.getValue("Settings", "ExcludePatterns",
+                                                      join_patterns(exclude_patterns)));
+    include_patterns = split_patterns(config.getValue("Settings", "IncludePatterns", ";"));
     skipped_version = config.getValue("Settings", "SkippedVersion", "0.0.0");
 
     return true;
@@ -115,6 +167,14 @@ bool Settings::save()
     config.setValue("Settings", "CategorizeFiles", categorize_files ? "true" : "false");
     config.setValue("Settings", "CategorizeDirectories", categorize_directories ? "true" : "false");
     config.setValue("Settings", "SortFolder", this->sort_folder);
+    config.setValue("Settings", "RecursiveScan", recursive_scan ? "true" : "false");
+    config.setValue("Settings", "MaxScanDepth", std::to_string(max_scan_depth));
+    config.setValue("Settings", "ContentSniffing", content_sniffing ? "true" : "false");
+    config.setValue("Settings", "PersistPromptCache", persist_prompt_cache ? "true" : "false");
+    config.setValue("Settings", "PreloadLocalModel", preload_local_model ? "true" : "false");
+    config.setValue("Settings", "LocalModelIdleMinutes", std::to_string(local_model_idle_minutes));
+    config.setValue("Settings", "ExcludePatterns", join_patterns(exclude_patterns));
+    config.setValue("Settings", "IncludePatterns", join_patterns(include_patterns));
 
     if (!skipped_version.empty()) {
         config.setValue("Settings", "SkippedVersion", skipped_version);
@@ -189,6 +249,102 @@ void Settings::set_sort_folder(const std::string &path)
 }
 
 
+bool Settings::get_recursive_scan() const
+{
+    return recursive_scan;
+}
+
+
+void Settings::set_recursive_scan(bool value)
+{
+    recursive_scan = value;
+}
+
+
+int Settings::get_max_scan_depth() const
+{
+    return max_scan_depth;
+}
+
+
+void Settings::set_max_scan_depth(int depth)
+{
+    max_scan_depth = depth;
+}
+
+
+bool Settings::get_content_sniffing() const
+{
+    return content_sniffing;
+}
+
+
+void Settings::set_content_sniffing(bool value)
+{
+    content_sniffing = value;
+}
+
+
+bool Settings::get_persist_prompt_cache() const
+{
+    return persist_prompt_cache;
+}
+
+
+void Settings::set_persist_prompt_cache(bool value)
+{
+    persist_prompt_cache = value;
+}
+
+
+bool Settings::get_preload_local_model() const
+{
+    return preload_local_model;
+}
+
+
+void Settings::set_preload_local_model(bool value)
+{
+    preload_local_model = value;
+}
+
+
+int Settings::get_local_model_idle_minutes() const
+{
+    return local_model_idle_minutes;
+}
+
+
+void Settings::set_local_model_idle_minutes(int minutes)
+{
+    local_model_idle_minutes = minutes;
+}
+
+
+std::vector<std::string> Settings::get_exclude_patterns() const
+{
+    return exclude_patterns;
+}
+
+
+void Settings::set_exclude_patterns(const std::vector<std::string> &patterns)
+{
+    exclude_patterns = patterns;
+}
+
+
+std::vector<std::string> Settings::get_include_patterns() const
+{
+    return include_patterns;
+}
+
+
+void Settings::set_include_patterns(const std::vector<std::string> &patterns)
+{
+    include_patterns = patterns;
+}
+
+
 void Settings::set_skipped_version(const std::string &version) {
     skipped_version = version;
 }
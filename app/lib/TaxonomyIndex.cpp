@@ -0,0 +1,139 @@
+#include "TaxonomyIndex.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Normalized labels only contain lowercase letters, digits and spaces.
+constexpr char kPad = '\x01';
+
+} // namespace
+
+
+void TaxonomyIndex::clear()
+{
+    category_postings.clear();
+    subcategory_postings.clear();
+    lengths.clear();
+}
+
+
+void TaxonomyIndex::add(size_t entry, std::string_view norm_category, std::string_view norm_subcategory)
+{
+    if (lengths.size() <= entry) {
+        lengths.resize(entry + 1, {0, 0});
+    }
+    lengths[entry] = {static_cast<std::uint32_t>(norm_category.size()),
+                      static_cast<std::uint32_t>(norm_subcategory.size())};
+
+    const auto id = static_cast<std::uint32_t>(entry);
+    for (const auto &[gram, count] : trigrams(norm_category)) {
+        category_postings[gram].push_back({id, count});
+    }
+    for (const auto &[gram, count] : trigrams(norm_subcategory)) {
+        subcategory_postings[gram].push_back({id, count});
+    }
+}
+
+
+std::vector<TaxonomyIndex::Candidate>
+TaxonomyIndex::candidates(std::string_view norm_category,
+                          std::string_view norm_subcategory,
+                          double threshold) const
+{
+    // Shared trigram counts (multiset intersection) per entry and label.
+    std::vector<std::uint32_t> category_common(lengths.size(), 0);
+    std::vector<std::uint32_t> subcategory_common(lengths.size(), 0);
+    std::vector<std::uint32_t> touched;
+
+    for (const auto &[gram, count] : trigrams(norm_category)) {
+        auto it = category_postings.find(gram);
+        if (it == category_postings.end()) continue;
+        for (const auto &posting : it->second) {
+            if (category_common[posting.entry] == 0) {
+                touched.push_back(posting.entry);
+            }
+            category_common[posting.entry] += std::min(count, posting.count);
+        }
+    }
+    if (touched.empty()) {
+        return {};
+    }
+    for (const auto &[gram, count] : trigrams(norm_subcategory)) {
+        auto it = subcategory_postings.find(gram);
+        if (it == subcategory_postings.end()) continue;
+        for (const auto &posting : it->second) {
+            subcategory_common[posting.entry] += std::min(count, posting.count);
+        }
+    }
+
+    // Sharing no trigram caps a label's similarity below 2/3, and the
+    // average below kMinThreshold, so such entries can be skipped.
+    std::vector<Candidate> result;
+    for (std::uint32_t entry : touched) {
+        if (subcategory_common[entry] == 0) continue;
+        const auto &[category_length, subcategory_length] = lengths[entry];
+        double bound =
+            (similarity_bound(norm_category.size(), category_length, category_common[entry]) +
+             similarity_bound(norm_subcategory.size(), subcategory_length, subcategory_common[entry])) / 2.0;
+        if (bound >= threshold) {
+            result.push_back({entry, bound});
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const Candidate &a, const Candidate &b) {
+        return a.upper_bound != b.upper_bound ? a.upper_bound > b.upper_bound : a.entry < b.entry;
+    });
+    return result;
+}
+
+
+std::vector<std::pair<TaxonomyIndex::Trigram, std::uint32_t>>
+TaxonomyIndex::trigrams(std::string_view label)
+{
+    std::string padded;
+    padded.reserve(label.size() + 4);
+    padded.append(2, kPad);
+    padded.append(label);
+    padded.append(2, kPad);
+
+    std::vector<std::pair<Trigram, std::uint32_t>> grams;
+    grams.reserve(padded.size() - 2);
+    for (size_t i = 0; i + 2 < padded.size(); ++i) {
+        Trigram gram = static_cast<unsigned char>(padded[i]) << 16 |
+                       static_cast<unsigned char>(padded[i + 1]) << 8 |
+                       static_cast<unsigned char>(padded[i + 2]);
+        grams.emplace_back(gram, 1);
+    }
+
+    std::sort(grams.begin(), grams.end());
+    size_t out = 0;
+    for (size_t i = 0; i < grams.size(); ++i) {
+        if (out > 0 && grams[out - 1].first == grams[i].first) {
+            ++grams[out - 1].second;
+        } else {
+            grams[out++] = grams[i];
+        }
+    }
+    grams.resize(out);
+    return grams;
+}
+
+
+double TaxonomyIndex::similarity_bound(size_t query_length, size_t entry_length, size_t common)
+{
+    // Mirrors EditDistance::similarity: 1 - distance / longer length,
+    // 1 for two empty labels and 0 when only one is empty.
+    if (query_length == 0 || entry_length == 0) {
+        return query_length == entry_length ? 1.0 : 0.0;
+    }
+
+    // A padded label of length n has n + 2 trigrams; one edit changes at most 3.
+    const size_t longer = std::max(query_length, entry_length);
+    const size_t grams = longer + 2;
+    size_t min_distance = common >= grams ? 0 : (grams - common + 2) / 3;
+    const size_t length_gap = query_length > entry_length ? query_length - entry_length
+                                                          : entry_length - query_length;
+    min_distance = std::max(min_distance, length_gap);
+    return 1.0 - static_cast<double>(min_distance) / static_cast<double>(longer);
+}
@@ -1,6 +1,8 @@
+#include "DatabaseManager.hpp"
 #include "EmbeddedEnv.hpp"
 #include "Logger.hpp"
 #include "LLMSelectionDialog.hpp"
+#include "LocalLLMClient.hpp"
 #include "MainApp.hpp"
 #include "Utils.hpp"
 #include <gio/gio.h>
@@ -8,6 +10,7 @@
 #include <libintl.h>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
 #include <curl/curl.h>
 
 #ifdef __linux__
@@ -33,10 +36,43 @@ bool initialize_loggers()
 }
 
 
+bool has_argument(int argc, char **argv, const char *argument)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], argument) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Maintenance: rebuilds the taxonomy usage counters, which are otherwise
+// kept up to date incrementally. Runs without opening a window.
+int recompute_taxonomy_frequencies()
+{
+    Settings settings;
+    settings.load();
+    DatabaseManager db_manager(settings.get_config_dir());
+
+    int updated = db_manager.recompute_taxonomy_frequencies();
+    if (updated < 0) {
+        std::fprintf(stderr, "Failed to recompute taxonomy frequencies.\n");
+        return EXIT_FAILURE;
+    }
+    std::printf("Recomputed frequencies for %d taxonomy entries.\n", updated);
+    return EXIT_SUCCESS;
+}
+
+
 int main(int argc, char **argv) {
     if (!initialize_loggers()) {
         return EXIT_FAILURE;
     }
+    if (has_argument(argc, argv, "--recompute-taxonomy-frequencies")) {
+        return recompute_taxonomy_frequencies();
+    }
+
     curl_global_init(CURL_GLOBAL_DEFAULT);
 
     #ifdef _WIN32
@@ -70,6 +106,11 @@ int main(int argc, char **argv) {
             settings.save();
         }
 
+        // setenv is not thread-safe; MainApp starts threads that load models.
+        if (settings.get_llm_choice() != LLMChoice::Remote) {
+            LocalLLMClient::prepare_environment();
+        }
+
         MainApp* main_app = new MainApp(argc, argv, settings);
         main_app->run();
         main_app->shutdown();